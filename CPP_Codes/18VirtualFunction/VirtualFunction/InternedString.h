@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//全局字符串驻留表：同样内容的字符串只存一份，每份对应一个32位id（0是空字符串）。
+//字符放在按块分配的arena里，永远不移动也不释放，所以拿到的string_view/c_str一直有效。
+//查找拿共享锁，第一次出现的字符串才拿独占锁插入；id→字符串是两级数组，读的时候不用锁。
+class InternTable
+{
+public:
+	struct Stats
+	{
+		size_t Count;       //不同字符串的个数
+		size_t StringBytes; //字符本身（包括结尾的0）
+		size_t ArenaBytes;  //arena实际申请的
+		size_t IndexBytes;  //哈希表和id表，估算
+	};
+
+	static InternTable& Get()
+	{
+		static InternTable instance;
+		return instance;
+	}
+
+	InternTable(const InternTable&) = delete;
+	InternTable& operator=(const InternTable&) = delete;
+
+	uint32_t Intern(std::string_view string)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+			auto it = m_Ids.find(string);
+			if (it != m_Ids.end())
+				return it->second;
+		}
+
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+		return InternLocked(string);
+	}
+
+	//一批字符串：已有的在一次共享锁里查完，缺的在一次独占锁里插完，不用每个字符串都抢一次锁
+	void InternBulk(const std::string_view* strings, size_t count, uint32_t* ids)
+	{
+		std::vector<size_t> missing;
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+			for (size_t i = 0; i < count; i++)
+			{
+				auto it = m_Ids.find(strings[i]);
+				if (it != m_Ids.end())
+					ids[i] = it->second;
+				else
+					missing.push_back(i);
+			}
+		}
+
+		if (missing.empty())
+			return;
+
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+		for (size_t i : missing)
+			ids[i] = InternLocked(strings[i]);
+	}
+
+	//id一定是Intern返回过的
+	std::string_view View(uint32_t id) const
+	{
+		return m_Pages[id >> PageBits][id & (PageSize - 1)];
+	}
+
+	Stats GetStats() const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		Stats stats;
+		stats.Count = m_Count;
+		stats.StringBytes = m_StringBytes;
+		stats.ArenaBytes = m_Blocks.size() * BlockSize + m_LargeBytes;
+		stats.IndexBytes = m_Ids.bucket_count() * sizeof(void*)
+			+ m_Ids.size() * (sizeof(std::pair<const std::string_view, uint32_t>) + 2 * sizeof(void*))
+			+ ((m_Count + PageSize - 1) / PageSize) * PageSize * sizeof(std::string_view)
+			+ sizeof(m_Pages);
+		return stats;
+	}
+
+	void PrintStats(std::ostream& stream = std::cout) const
+	{
+		Stats stats = GetStats();
+		stream << "Interned " << stats.Count << " strings: " << stats.StringBytes << " bytes of text, "
+			<< stats.ArenaBytes << " bytes of arena, ~" << stats.IndexBytes << " bytes of index" << std::endl;
+	}
+
+private:
+	static constexpr uint32_t PageBits = 12;
+	static constexpr uint32_t PageSize = 1u << PageBits;
+	static constexpr uint32_t MaxPages = 1u << 12; //最多1600万个不同的字符串
+	static constexpr size_t BlockSize = 64 * 1024;
+
+	InternTable()
+	{
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+		InternLocked(std::string_view()); //id 0
+	}
+
+	uint32_t InternLocked(std::string_view string)
+	{
+		//两个线程可能同时发现它不存在
+		auto it = m_Ids.find(string);
+		if (it != m_Ids.end())
+			return it->second;
+
+		uint32_t id = m_Count;
+		if ((id >> PageBits) >= MaxPages)
+			throw std::length_error("InternTable is full");
+
+		std::string_view stored = Store(string);
+		if ((id & (PageSize - 1)) == 0)
+			m_Pages[id >> PageBits] = std::make_unique<std::string_view[]>(PageSize);
+		m_Pages[id >> PageBits][id & (PageSize - 1)] = stored;
+
+		m_Ids.emplace(stored, id);
+		m_Count++;
+		m_StringBytes += string.size() + 1;
+		return id;
+	}
+
+	//把字符拷到arena里，带结尾的0，这样View().data()可以直接当c_str用
+	std::string_view Store(std::string_view string)
+	{
+		size_t size = string.size() + 1;
+		char* memory;
+		if (size > BlockSize / 4)
+		{
+			//很长的单独分配，不浪费块尾
+			m_Large.push_back(std::make_unique<char[]>(size));
+			m_LargeBytes += size;
+			memory = m_Large.back().get();
+		}
+		else
+		{
+			if (m_Blocks.empty() || m_BlockUsed + size > BlockSize)
+			{
+				m_Blocks.push_back(std::make_unique<char[]>(BlockSize));
+				m_BlockUsed = 0;
+			}
+			memory = m_Blocks.back().get() + m_BlockUsed;
+			m_BlockUsed += size;
+		}
+
+		if (!string.empty())
+			memcpy(memory, string.data(), string.size());
+		memory[string.size()] = 0;
+		return std::string_view(memory, string.size());
+	}
+
+	mutable std::shared_mutex m_Mutex;
+	std::unordered_map<std::string_view, uint32_t> m_Ids;
+	std::unique_ptr<std::string_view[]> m_Pages[MaxPages];
+	uint32_t m_Count = 0;
+	size_t m_StringBytes = 0;
+
+	std::vector<std::unique_ptr<char[]>> m_Blocks;
+	size_t m_BlockUsed = 0;
+	std::vector<std::unique_ptr<char[]>> m_Large;
+	size_t m_LargeBytes = 0;
+};
+
+//驻留字符串的句柄，只有4个字节。相等/哈希都只比较id，和字符串多长没有关系。
+//内容相同的字符串id一定相同，所以id不同就是内容不同。
+class InternedString
+{
+public:
+	InternedString() = default;
+
+	InternedString(std::string_view string)
+		: m_Id(InternTable::Get().Intern(string))
+	{
+	}
+
+	InternedString(const char* string)
+		: InternedString(std::string_view(string))
+	{
+	}
+
+	static std::vector<InternedString> InternAll(const std::vector<std::string_view>& strings)
+	{
+		std::vector<uint32_t> ids(strings.size());
+		InternTable::Get().InternBulk(strings.data(), strings.size(), ids.data());
+
+		std::vector<InternedString> result;
+		result.reserve(ids.size());
+		for (uint32_t id : ids)
+			result.push_back(FromId(id));
+		return result;
+	}
+
+	uint32_t Id() const { return m_Id; }
+	bool Empty() const { return m_Id == 0; }
+
+	std::string_view View() const { return InternTable::Get().View(m_Id); }
+	const char* CStr() const { return View().data(); }
+
+	bool operator==(const InternedString& other) const { return m_Id == other.m_Id; }
+	bool operator!=(const InternedString& other) const { return m_Id != other.m_Id; }
+
+	friend std::ostream& operator<<(std::ostream& stream, const InternedString& string);
+
+private:
+	static InternedString FromId(uint32_t id)
+	{
+		InternedString string;
+		string.m_Id = id;
+		return string;
+	}
+
+	uint32_t m_Id = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& stream, const InternedString& string)
+{
+	stream << string.View();
+	return stream;
+}
+
+namespace std
+{
+	template<>
+	struct hash<InternedString>
+	{
+		size_t operator()(const InternedString& string) const noexcept
+		{
+			return string.Id();
+		}
+	};
+}
@@ -1,26 +1,37 @@
 ﻿#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "InternedString.h"
 
 class Entity
 {
 public:
-	virtual std::string GetName()
+	virtual std::string_view GetName()
 	{
 		return "Entity";
 	}
 };
 
+//名字是驻留的：一百万个叫"Cherno"的Player共用一份字符，每个Player只存一个4字节的id
 class Player : public Entity
 {
 private:
-	std::string m_Name;
+	InternedString m_Name;
 public:
-	Player(const std::string& name) : m_Name(name)
+	Player(InternedString name) : m_Name(name)
+	{
+	}
+
+	std::string_view GetName() override
 	{
+		return m_Name.View();
 	}
 
-	std::string GetName() override
+	bool HasSameName(const Player& other) const
 	{
-		return m_Name;
+		return m_Name == other.m_Name;//比较id，不用逐字节比
 	}
 };
 
@@ -37,6 +48,17 @@ int main()
 	Player* p = new Player("Cherno");
 	PrintName(p);//即使是Entity*接收的，我依然想要打印Cherno，因为我传的是Player*,通过virtual可以实现
 
+	//一批名字一次驻留完，重复的名字只存一份
+	std::vector<std::string_view> names = { "Cherno", "Yan", "Player", "Enemy", "Boss" };
+	std::vector<InternedString> interned = InternedString::InternAll(names);
+
+	std::vector<Player> players;
+	players.reserve(1000000);
+	for (int i = 0; i < 1000000; i++)
+		players.emplace_back(interned[i % interned.size()]);
+	std::cout << players.size() << " players, sizeof(Player) = " << sizeof(Player)
+		<< ", same name: " << players[0].HasSameName(*p) << std::endl;
+	InternTable::Get().PrintStats();
+
 	std::cin.get();
 }
-
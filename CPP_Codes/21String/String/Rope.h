@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//Rope：很长的字符串存成一棵平衡二叉树，叶子是不可变的字符块，内部结点只记录左右子树和总长度。
+//拼接、取子串、按下标访问都是O(log n)，不会像std::string那样把整个缓冲区重新分配再拷贝一遍。
+//结点创建之后就不再修改，用shared_ptr共享：拷贝Rope是O(1)，子串和原来的Rope共用同一批字符块，多个线程可以同时读。
+//
+//树按AVL的规则保持平衡（左右子树高度最多差1），拼接时沿着高的那棵树的边往下找高度合适的位置接上去，再往上旋转。
+//很短的字符块拼在一起时直接合并成一个叶子（最多MaxMergedLeaf字节），一个一个字符串追加时不会产生大量很小的叶子。
+//
+//取子串时叶子直接引用原来的字符块，所以一个很小的子串也会让整个字符块一直活着；需要的话Flatten()出来再构造一个新的。
+class Rope
+{
+public:
+	static constexpr size_t MaxMergedLeaf = 512;
+
+	Rope() = default;
+
+	Rope(std::string_view string)
+		: Rope(std::string(string))
+	{
+	}
+
+	Rope(const char* string)
+		: Rope(std::string_view(string))
+	{
+	}
+
+	//把string整个拿过来当作一个字符块，不拷贝
+	Rope(std::string&& string)
+		: m_Root(string.empty() ? nullptr : MakeLeaf(std::make_shared<const std::string>(std::move(string))))
+	{
+	}
+
+	size_t Size() const { return m_Root ? m_Root->Size : 0; }
+	bool Empty() const { return !m_Root; }
+
+	//树的高度（叶子是0）
+	int Height() const { return m_Root ? m_Root->Height : -1; }
+
+	char operator[](size_t index) const
+	{
+		const Node* node = m_Root.get();
+		while (!node->IsLeaf())
+		{
+			size_t leftSize = node->Left->Size;
+			if (index < leftSize)
+			{
+				node = node->Left.get();
+			}
+			else
+			{
+				index -= leftSize;
+				node = node->Right.get();
+			}
+		}
+		return (*node->Text)[node->Offset + index];
+	}
+
+	char At(size_t index) const
+	{
+		if (index >= Size())
+			throw std::out_of_range("Rope::At");
+		return (*this)[index];
+	}
+
+	Rope& operator+=(const Rope& other)
+	{
+		m_Root = Join(m_Root, other.m_Root);
+		return *this;
+	}
+
+	Rope& operator+=(std::string_view string)
+	{
+		return *this += Rope(string);
+	}
+
+	friend Rope operator+(Rope a, const Rope& b)
+	{
+		a += b;
+		return a;
+	}
+
+	//[position, position + count)，count超出结尾时截到结尾（和std::string::substr一样）
+	Rope Substr(size_t position, size_t count = std::string::npos) const
+	{
+		if (position > Size())
+			throw std::out_of_range("Rope::Substr");
+		size_t end = position + std::min(count, Size() - position);
+		return Rope(Slice(m_Root, position, end));
+	}
+
+	//拼成一整块连续的内存
+	std::string Flatten() const
+	{
+		std::string result;
+		result.reserve(Size());
+		ForEachChunk([&](std::string_view chunk) { result.append(chunk.data(), chunk.size()); });
+		return result;
+	}
+
+	//按顺序访问每个字符块，比如攒成iovec一次writev出去，不用先拼起来
+	template<typename Function>
+	void ForEachChunk(Function&& function) const
+	{
+		//树高是O(log n)，用显式的栈代替递归
+		std::vector<const Node*> stack;
+		if (m_Root)
+			stack.push_back(m_Root.get());
+		while (!stack.empty())
+		{
+			const Node* node = stack.back();
+			stack.pop_back();
+			if (node->IsLeaf())
+			{
+				function(std::string_view(node->Text->data() + node->Offset, node->Size));
+			}
+			else
+			{
+				stack.push_back(node->Right.get());
+				stack.push_back(node->Left.get());
+			}
+		}
+	}
+
+	std::vector<std::string_view> Chunks() const
+	{
+		std::vector<std::string_view> chunks;
+		ForEachChunk([&](std::string_view chunk) { chunks.push_back(chunk); });
+		return chunks;
+	}
+
+	friend std::ostream& operator<<(std::ostream& stream, const Rope& rope);
+
+private:
+	struct Node;
+	using NodePtr = std::shared_ptr<const Node>;
+
+	//叶子：Text里从Offset开始的Size个字符；内部结点：Left + Right
+	struct Node
+	{
+		size_t Size = 0;
+		int Height = 0;
+		NodePtr Left;
+		NodePtr Right;
+		std::shared_ptr<const std::string> Text;
+		size_t Offset = 0;
+
+		bool IsLeaf() const { return Text != nullptr; }
+	};
+
+	explicit Rope(NodePtr root)
+		: m_Root(std::move(root))
+	{
+	}
+
+	static NodePtr MakeLeaf(std::shared_ptr<const std::string> text, size_t offset = 0, size_t size = std::string::npos)
+	{
+		auto node = std::make_shared<Node>();
+		node->Size = size == std::string::npos ? text->size() - offset : size;
+		node->Text = std::move(text);
+		node->Offset = offset;
+		return node;
+	}
+
+	//左右高度最多差1的时候才能直接调用
+	static NodePtr MakeNode(NodePtr left, NodePtr right)
+	{
+		auto node = std::make_shared<Node>();
+		node->Size = left->Size + right->Size;
+		node->Height = std::max(left->Height, right->Height) + 1;
+		node->Left = std::move(left);
+		node->Right = std::move(right);
+		return node;
+	}
+
+	//两个短叶子合成一个：只拷贝几百个字节，换来树里少一个结点。
+	//只在两边真的是挨着的叶子时用（旋转里不用），合出来的叶子高度是0，不会比原来的子树高
+	static NodePtr MakeNodeOrMerge(const NodePtr& left, const NodePtr& right)
+	{
+		if (left->IsLeaf() && right->IsLeaf() && left->Size + right->Size <= MaxMergedLeaf)
+		{
+			std::string text;
+			text.reserve(left->Size + right->Size);
+			text.append(left->Text->data() + left->Offset, left->Size);
+			text.append(right->Text->data() + right->Offset, right->Size);
+			return MakeLeaf(std::make_shared<const std::string>(std::move(text)));
+		}
+		return MakeNode(left, right);
+	}
+
+	//  (a (b c)) -> ((a b) c)
+	static NodePtr RotateLeft(const NodePtr& node)
+	{
+		return MakeNode(MakeNode(node->Left, node->Right->Left), node->Right->Right);
+	}
+
+	//  ((a b) c) -> (a (b c))
+	static NodePtr RotateRight(const NodePtr& node)
+	{
+		return MakeNode(node->Left->Left, MakeNode(node->Left->Right, node->Right));
+	}
+
+	//把两棵树按顺序拼起来，代价是O(两棵树的高度差 + 1)
+	static NodePtr Join(const NodePtr& left, const NodePtr& right)
+	{
+		if (!left)
+			return right;
+		if (!right)
+			return left;
+		if (left->Height > right->Height + 1)
+			return JoinRight(left, right);
+		if (right->Height > left->Height + 1)
+			return JoinLeft(left, right);
+		return MakeNodeOrMerge(left, right);
+	}
+
+	//left比right高2以上：沿着left的右边往下，找到和right差不多高的子树接上，再往回旋转保持平衡
+	static NodePtr JoinRight(const NodePtr& left, const NodePtr& right)
+	{
+		const NodePtr& outer = left->Left;
+		const NodePtr& inner = left->Right;
+		if (inner->Height <= right->Height + 1)
+		{
+			NodePtr joined = MakeNodeOrMerge(inner, right);
+			if (joined->Height <= outer->Height + 1)
+				return MakeNode(outer, joined);
+			return RotateLeft(MakeNode(outer, RotateRight(joined)));
+		}
+
+		NodePtr joined = JoinRight(inner, right);
+		NodePtr node = MakeNode(outer, joined);
+		if (joined->Height <= outer->Height + 1)
+			return node;
+		return RotateLeft(node);
+	}
+
+	static NodePtr JoinLeft(const NodePtr& left, const NodePtr& right)
+	{
+		const NodePtr& outer = right->Right;
+		const NodePtr& inner = right->Left;
+		if (inner->Height <= left->Height + 1)
+		{
+			NodePtr joined = MakeNodeOrMerge(left, inner);
+			if (joined->Height <= outer->Height + 1)
+				return MakeNode(joined, outer);
+			return RotateRight(MakeNode(RotateLeft(joined), outer));
+		}
+
+		NodePtr joined = JoinLeft(left, inner);
+		NodePtr node = MakeNode(joined, outer);
+		if (joined->Height <= outer->Height + 1)
+			return node;
+		return RotateRight(node);
+	}
+
+	//node里的[begin, end)：完整包含的子树直接复用，只有两条边界路径上的结点需要重新拼，一共O(log n)
+	static NodePtr Slice(const NodePtr& node, size_t begin, size_t end)
+	{
+		if (begin >= end)
+			return nullptr;
+		if (begin == 0 && end == node->Size)
+			return node;
+		if (node->IsLeaf())
+			return MakeLeaf(node->Text, node->Offset + begin, end - begin);
+
+		size_t leftSize = node->Left->Size;
+		if (end <= leftSize)
+			return Slice(node->Left, begin, end);
+		if (begin >= leftSize)
+			return Slice(node->Right, begin - leftSize, end - leftSize);
+		return Join(Slice(node->Left, begin, leftSize), Slice(node->Right, 0, end - leftSize));
+	}
+
+	NodePtr m_Root; //空字符串是nullptr
+};
+
+inline std::ostream& operator<<(std::ostream& stream, const Rope& rope)
+{
+	rope.ForEachChunk([&](std::string_view chunk) { stream.write(chunk.data(), (std::streamsize)chunk.size()); });
+	return stream;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+//StrCat("user:", id, ":", name)：先算出总长度，只分配一次，每一段只拷贝一次。
+//a + b + c + ...每个+都会生成一个临时的std::string，n段就可能分配n-1次、前面的内容被反复拷贝。
+//
+//StrPiece是"一段"：字符串类的参数只记下指针和长度（不拷贝），整数在自己的小缓冲区里转成十进制。
+//和string_view一样，StrPiece/StrCatExpression不拥有它引用的字符串，不能活得比参数更久。
+class StrPiece
+{
+public:
+	StrPiece(const char* string)
+		: m_Data(string), m_Size(strlen(string))
+	{
+	}
+
+	StrPiece(const std::string& string)
+		: m_Data(string.data()), m_Size(string.size())
+	{
+	}
+
+	StrPiece(std::string_view string)
+		: m_Data(string.data()), m_Size(string.size())
+	{
+	}
+
+	//单个字符就是它本身，不是数字
+	StrPiece(char c)
+		: m_Data(nullptr), m_Size(1)
+	{
+		m_Digits[0] = c;
+	}
+
+	//整数转成十进制，最长的是INT64_MIN，20个字符
+	template<typename Integer, typename = std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, bool> && !std::is_same_v<Integer, char>>>
+	StrPiece(Integer value)
+		: m_Data(nullptr)
+	{
+		std::to_chars_result result = std::to_chars(m_Digits, m_Digits + sizeof(m_Digits), value);
+		m_Size = (size_t)(result.ptr - m_Digits);
+	}
+
+	StrPiece(bool) = delete; //StrCat("ok: ", true)多半是写错了，要"1"还是"true"自己决定
+
+	//m_Data为空时字符在m_Digits里，这样拷贝StrPiece之后也不会指向别人的缓冲区
+	const char* Data() const { return m_Data ? m_Data : m_Digits; }
+	size_t Size() const { return m_Size; }
+
+private:
+	const char* m_Data;
+	size_t m_Size;
+	char m_Digits[20];
+};
+
+//把pieces依次拷到destination后面（只扩容一次）
+inline void StrAppendPieces(std::string& destination, std::initializer_list<StrPiece> pieces)
+{
+	size_t size = 0;
+	for (const StrPiece& piece : pieces)
+		size += piece.Size();
+
+	size_t offset = destination.size();
+	destination.resize(offset + size);
+	char* out = destination.data() + offset;
+	for (const StrPiece& piece : pieces)
+	{
+		memcpy(out, piece.Data(), piece.Size());
+		out += piece.Size();
+	}
+}
+
+template<typename... Args>
+std::string StrCat(const Args&... args)
+{
+	std::string result;
+	StrAppendPieces(result, { StrPiece(args)... });
+	return result;
+}
+
+//往已有的字符串后面接，比一段一段+=少几次扩容
+template<typename... Args>
+void StrAppend(std::string& destination, const Args&... args)
+{
+	StrAppendPieces(destination, { StrPiece(args)... });
+}
+
+//延迟拼接：Cat("kk") + " hello" + 42 只是把每一段记下来（段数在编译期就知道，不分配），
+//转换成std::string的时候才一次性分配、拷贝。适合像a + b + c这样一段一段写出来的代码
+template<size_t N>
+class StrCatExpression
+{
+public:
+	explicit StrCatExpression(const std::array<StrPiece, N>& pieces)
+		: m_Pieces(pieces)
+	{
+	}
+
+	template<typename T>
+	StrCatExpression<N + 1> operator+(const T& piece) const
+	{
+		return Extend(StrPiece(piece), std::make_index_sequence<N>());
+	}
+
+	size_t Size() const
+	{
+		size_t size = 0;
+		for (const StrPiece& piece : m_Pieces)
+			size += piece.Size();
+		return size;
+	}
+
+	void AppendTo(std::string& destination) const
+	{
+		size_t offset = destination.size();
+		destination.resize(offset + Size());
+		char* out = destination.data() + offset;
+		for (const StrPiece& piece : m_Pieces)
+		{
+			memcpy(out, piece.Data(), piece.Size());
+			out += piece.Size();
+		}
+	}
+
+	std::string Str() const
+	{
+		std::string result;
+		AppendTo(result);
+		return result;
+	}
+
+	operator std::string() const
+	{
+		return Str();
+	}
+
+private:
+	template<size_t... Indices>
+	StrCatExpression<N + 1> Extend(const StrPiece& piece, std::index_sequence<Indices...>) const
+	{
+		return StrCatExpression<N + 1>(std::array<StrPiece, N + 1>{ { m_Pieces[Indices]..., piece } });
+	}
+
+	std::array<StrPiece, N> m_Pieces;
+};
+
+inline StrCatExpression<1> Cat(const StrPiece& piece)
+{
+	return StrCatExpression<1>(std::array<StrPiece, 1>{ { piece } });
+}
@@ -1,6 +1,11 @@
+#include <chrono>
 #include <iostream>
 #include <string>
 
+#include "AllocationCounter.h"
+#include "Rope.h"
+#include "StrCat.h"
+
 int main()
 {
 	//const char* name = "Cherno";//no new,no delete.
@@ -14,5 +19,57 @@ int main()
 
 	std::cout << name << std::endl;
 
+	//10段拼成一个key：每个+都生成一个临时的std::string；StrCat先算总长度，只分配一次
+	unsigned long long userId = 12345678901ull;
+	std::string region = "ap-southeast-1";
+	std::string_view table = "sessions";
+	int shard = 42;
+
+	{
+		//只数这一段的堆分配，后面的计时不受计数影响
+		benchmark::ScopedAllocationCounting counting;
+
+		uint64_t before = benchmark::ThreadAllocations().Count;
+		std::string plusKey = std::string("user:") + std::to_string(userId) + ":" + region + ":" + std::string(table)
+			+ ":shard-" + std::to_string(shard) + ":v" + std::to_string(3);
+		uint64_t plusAllocations = benchmark::ThreadAllocations().Count - before;
+
+		before = benchmark::ThreadAllocations().Count;
+		std::string key = StrCat("user:", userId, ":", region, ":", table, ":shard-", shard, ":v", 3);
+		uint64_t strCatAllocations = benchmark::ThreadAllocations().Count - before;
+
+		//写法和+一样，但只在最后转换成std::string时分配一次
+		before = benchmark::ThreadAllocations().Count;
+		std::string lazyKey = Cat("user:") + userId + ":" + region + ":" + table + ":shard-" + shard + ":v" + 3;
+		uint64_t lazyAllocations = benchmark::ThreadAllocations().Count - before;
+
+		std::cout << key << ": operator+ " << plusAllocations << " allocations, StrCat " << strCatAllocations
+			<< ", Cat(...) + ... " << lazyAllocations << (key == plusKey && key == lazyKey ? "" : " MISMATCH") << std::endl;
+	}
+
+	//拼一份几MB的文档：每一段都插到最前面。std::string每插一次都要把后面已有的内容整个往后挪，Rope只是在树上接一个叶子
+	const int paragraphs = 10000;
+	std::string paragraph = "[info] request handled in 12ms by worker 7, nothing else to report here.\n";
+
+	auto start = std::chrono::steady_clock::now();
+	std::string flat;
+	for (int i = 0; i < paragraphs; i++)
+		flat.insert(0, paragraph);
+	double flatMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	Rope rope;
+	for (int i = 0; i < paragraphs; i++)
+		rope = Rope(paragraph) + rope;
+	double ropeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << rope.Size() << " bytes: std::string " << flatMs << "ms, Rope " << ropeMs << "ms (height " << rope.Height()
+		<< ", " << rope.Chunks().size() << " chunks)" << std::endl;
+
+	//子串和下标也是O(log n)；要交给只认连续内存的接口时再Flatten
+	Rope middle = rope.Substr(rope.Size() / 2, paragraph.size());
+	std::cout << "middle: " << middle;
+	std::cout << "same content: " << (rope.Flatten() == flat) << ", last char code: " << (int)rope[rope.Size() - 1] << std::endl;
+
 	std::cin.get();
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+﻿#include "HashBenchmark.h"
+#include "StringHash.h"
+
+#include "Benchmark.h"
+
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace hash::literals;
+
+namespace
+{
+	constexpr auto s_Fields = hash::MakePerfectHash(
+		"id", "name", "email", "age", "country", "city", "zip", "phone",
+		"created_at", "updated_at", "status", "role", "avatar", "locale", "timezone", "last_login");
+
+	//只差大小写（0x20）、只差最高位（0x80）、只差高几位的key：FNV-1a的低位分不开它们，PerfectHash要能分开
+	constexpr auto s_SimilarKeys = hash::MakePerfectHash("get", "GET", "put", "PUT", "on", "ov", "\x01", "\x81", "\x41", "\xC1");
+	static_assert(s_SimilarKeys.Find("get") == 0 && s_SimilarKeys.Find("GET") == 1 && s_SimilarKeys.Find("PUT") == 3, "case-only differences");
+	static_assert(s_SimilarKeys.Find("on") == 4 && s_SimilarKeys.Find("ov") == 5, "differ only above the low bits");
+	static_assert(s_SimilarKeys.Find("\x01") == 6 && s_SimilarKeys.Find("\x81") == 7 && s_SimilarKeys.Find("\xC1") == 9, "differ only in the high bits");
+	static_assert(s_SimilarKeys.Find("Get") == hash::PerfectHash<10>::NotFound && s_SimilarKeys.Find("") == hash::PerfectHash<10>::NotFound, "unknown keys");
+
+	//常见的写法：从上往下一个一个比，靠后的字段和不认识的字段要比完整条链
+	int FieldByStrcmp(const char* name)
+	{
+		if (strcmp(name, "id") == 0) return 1;
+		else if (strcmp(name, "name") == 0) return 2;
+		else if (strcmp(name, "email") == 0) return 3;
+		else if (strcmp(name, "age") == 0) return 4;
+		else if (strcmp(name, "country") == 0) return 5;
+		else if (strcmp(name, "city") == 0) return 6;
+		else if (strcmp(name, "zip") == 0) return 7;
+		else if (strcmp(name, "phone") == 0) return 8;
+		else if (strcmp(name, "created_at") == 0) return 9;
+		else if (strcmp(name, "updated_at") == 0) return 10;
+		else if (strcmp(name, "status") == 0) return 11;
+		else if (strcmp(name, "role") == 0) return 12;
+		else if (strcmp(name, "avatar") == 0) return 13;
+		else if (strcmp(name, "locale") == 0) return 14;
+		else if (strcmp(name, "timezone") == 0) return 15;
+		else if (strcmp(name, "last_login") == 0) return 16;
+		return 0;
+	}
+
+	int FieldByMap(std::string_view name)
+	{
+		static const std::unordered_map<std::string_view, int> fields = {
+			{ "id", 1 }, { "name", 2 }, { "email", 3 }, { "age", 4 }, { "country", 5 }, { "city", 6 }, { "zip", 7 }, { "phone", 8 },
+			{ "created_at", 9 }, { "updated_at", 10 }, { "status", 11 }, { "role", 12 }, { "avatar", 13 }, { "locale", 14 },
+			{ "timezone", 15 }, { "last_login", 16 } };
+		auto it = fields.find(name);
+		return it == fields.end() ? 0 : it->second;
+	}
+
+	//case的哈希值是编译期算好的常量；输入可能是任意字符串，命中之后再比较一次确认
+	int FieldByHashSwitch(std::string_view name)
+	{
+		int field;
+		switch (hash::Fnv1a(name))
+		{
+		case "id"_hash: field = 1; break;
+		case "name"_hash: field = 2; break;
+		case "email"_hash: field = 3; break;
+		case "age"_hash: field = 4; break;
+		case "country"_hash: field = 5; break;
+		case "city"_hash: field = 6; break;
+		case "zip"_hash: field = 7; break;
+		case "phone"_hash: field = 8; break;
+		case "created_at"_hash: field = 9; break;
+		case "updated_at"_hash: field = 10; break;
+		case "status"_hash: field = 11; break;
+		case "role"_hash: field = 12; break;
+		case "avatar"_hash: field = 13; break;
+		case "locale"_hash: field = 14; break;
+		case "timezone"_hash: field = 15; break;
+		case "last_login"_hash: field = 16; break;
+		default: return 0;
+		}
+		return s_Fields.Key(field - 1) == name ? field : 0;
+	}
+
+	//Find已经比较过字符串，case的下标也是编译期算好的
+	int FieldByPerfectHash(std::string_view name)
+	{
+		switch (s_Fields.Find(name))
+		{
+		case s_Fields.Index("id"): return 1;
+		case s_Fields.Index("name"): return 2;
+		case s_Fields.Index("email"): return 3;
+		case s_Fields.Index("age"): return 4;
+		case s_Fields.Index("country"): return 5;
+		case s_Fields.Index("city"): return 6;
+		case s_Fields.Index("zip"): return 7;
+		case s_Fields.Index("phone"): return 8;
+		case s_Fields.Index("created_at"): return 9;
+		case s_Fields.Index("updated_at"): return 10;
+		case s_Fields.Index("status"): return 11;
+		case s_Fields.Index("role"): return 12;
+		case s_Fields.Index("avatar"): return 13;
+		case s_Fields.Index("locale"): return 14;
+		case s_Fields.Index("timezone"): return 15;
+		case s_Fields.Index("last_login"): return 16;
+		default: return 0;
+		}
+	}
+
+	//每个字段出现的机会一样，另外大约十分之一是不认识的字段名
+	std::vector<std::string> MakeInputs(size_t count)
+	{
+		std::mt19937 random(42);
+		std::uniform_int_distribution<size_t> pick(0, s_Fields.Size() + 1);
+		std::vector<std::string> inputs;
+		inputs.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t index = pick(random);
+			if (index < s_Fields.Size())
+				inputs.emplace_back(s_Fields.Key((int)index));
+			else
+				inputs.emplace_back(index == s_Fields.Size() ? "nickname" : "created");
+		}
+		return inputs;
+	}
+
+	template<typename Fn>
+	double NanosecondsPerLookup(const std::string& name, size_t lookups, Fn&& fn)
+	{
+		benchmark::Options options;
+		options.WarmupRuns = 1;
+		options.Samples = 5;
+		options.MinSampleNanoseconds = 5'000'000;
+		return benchmark::Run(name, fn, options).Median / lookups;
+	}
+}
+
+void RunHashBenchmark()
+{
+	std::vector<std::string> inputs = MakeInputs(4096);
+
+	//运行时建表走的是同一段代码，也不能卡在找种子上
+	std::string on = "on", ov = "ov";
+	hash::PerfectHash<2> runtimeKeys = hash::MakePerfectHash(on.c_str(), ov.c_str());
+	if (runtimeKeys.Find("on") != 0 || runtimeKeys.Find("ov") != 1)
+	{
+		std::cout << "runtime PerfectHash failed" << std::endl;
+		return;
+	}
+
+	//四种写法结果必须一样
+	long long expected = 0;
+	for (const std::string& input : inputs)
+	{
+		int field = FieldByStrcmp(input.c_str());
+		if (FieldByMap(input) != field || FieldByHashSwitch(input) != field || FieldByPerfectHash(input) != field)
+		{
+			std::cout << "mismatch on \"" << input << "\"" << std::endl;
+			return;
+		}
+		expected += field;
+	}
+
+	auto run = [&](const std::string& name, auto&& lookup)
+	{
+		return NanosecondsPerLookup(name, inputs.size(), [&]()
+		{
+			long long sum = 0;
+			for (const std::string& input : inputs)
+				sum += lookup(input);
+			benchmark::DoNotOptimize(sum);
+		});
+	};
+
+	struct Result
+	{
+		const char* Name;
+		double Nanoseconds;
+	};
+	Result results[] = {
+		{ "strcmp chain", run("strcmp", [](const std::string& s) { return FieldByStrcmp(s.c_str()); }) },
+		{ "unordered_map", run("map", [](const std::string& s) { return FieldByMap(s); }) },
+		{ "switch on _hash", run("switch", [](const std::string& s) { return FieldByHashSwitch(s); }) },
+		{ "perfect hash", run("perfect", [](const std::string& s) { return FieldByPerfectHash(s); }) },
+	};
+
+	std::cout << "Field-name dispatch, " << s_Fields.Size() << " fields, " << inputs.size() << " lookups (checksum " << expected << ")" << std::endl;
+	std::cout << std::left << std::setw(24) << "method" << std::right << std::setw(14) << "ns/lookup" << std::endl;
+	for (const Result& result : results)
+		std::cout << std::left << std::setw(24) << result.Name << std::right << std::fixed << std::setprecision(2) << std::setw(14) << result.Nanoseconds << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+//按字段名分发：一串strcmp、unordered_map、switch (Fnv1a(name)) { case "id"_hash: }、编译期完美哈希表，
+//每次查找的平均耗时（纳秒）
+void RunHashBenchmark();
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+//编译期字符串哈希。字面量的内容编译时就知道，它的哈希也可以在编译时算好：
+//  switch (hash::Fnv1a(name)) { case "id"_hash: ...; case "name"_hash: ...; }
+//运行时只对输入算一次哈希，然后是一次switch跳转，而不是一串strcmp。
+//两个不同的字符串可能哈希相同：输入不可信时，命中之后还要再比较一次字符串，或者直接用下面的PerfectHash（它会比较）。
+namespace hash
+{
+	inline constexpr uint64_t FnvOffsetBasis = 14695981039346656037ull;
+	inline constexpr uint64_t FnvPrime = 1099511628211ull;
+
+	//64位FNV-1a：每个字节先异或再乘。编译期和运行时是同一个函数，结果一定一样
+	constexpr uint64_t Fnv1a(std::string_view string, uint64_t basis = FnvOffsetBasis)
+	{
+		uint64_t hash = basis;
+		for (char c : string)
+		{
+			hash ^= (unsigned char)c;
+			hash *= FnvPrime;
+		}
+		return hash;
+	}
+
+	namespace literals
+	{
+		constexpr uint64_t operator""_hash(const char* string, size_t size)
+		{
+			return Fnv1a(std::string_view(string, size));
+		}
+	}
+
+	//完美哈希：编译时给一组固定的key找一个种子，让每个key落在表里不同的格子上。
+	//运行时Find对输入算一次哈希、看一个格子、比较一次字符串，就知道它是第几个key，不是任何一个key时返回NotFound。
+	//
+	//FNV-1a的乘法只会把低位往高位进位，哈希的低几位只取决于每个字节的低几位，换种子也分不开"on"和"ov"这样的key。
+	//所以先用MurmurHash3的fmix64把所有位搅匀，再取最高的几位当格子的下标。
+	template<size_t N>
+	class PerfectHash
+	{
+	public:
+		static constexpr int NotFound = -1;
+		static constexpr int MaxAttempts = 1000;
+
+		//格子数随N²增长（见下面的TableBits）：256个key是16384个格子、32KB。再多就不适合放进编译期对象了，用std::unordered_map
+		static constexpr size_t MaxKeys = 256;
+		static_assert(N <= MaxKeys, "PerfectHash: the slot table grows as N*N/4; use std::unordered_map for larger key sets");
+
+		//2的幂。N个key随机落进M个格子，全都不冲突的概率大约是e^(-N²/2M)：
+		//M至少N²/4时平均几次就能找到种子；key少的时候至少是key个数的两倍
+		static constexpr int TableBits = []()
+		{
+			int bits = 0;
+			while (((size_t)1 << bits) < 2 * N || ((size_t)1 << bits) < N * N / 4)
+				bits++;
+			return bits;
+		}();
+		static constexpr size_t TableSize = (size_t)1 << TableBits;
+
+		//有重复的key，或者MaxAttempts个种子都有冲突时抛异常（在编译期就是编译错误）
+		constexpr explicit PerfectHash(const std::array<std::string_view, N>& keys)
+			: m_Keys(keys)
+		{
+			for (size_t i = 0; i < N; i++)
+			{
+				for (size_t j = i + 1; j < N; j++)
+				{
+					if (m_Keys[i] == m_Keys[j])
+						throw std::invalid_argument("PerfectHash: duplicate key");
+				}
+			}
+
+			for (int attempt = 0; attempt < MaxAttempts; attempt++)
+			{
+				if (TryBuild(FnvOffsetBasis + (uint64_t)attempt * 0x9E3779B97F4A7C15ull))
+					return;
+			}
+			throw std::runtime_error("PerfectHash: no collision-free seed found");
+		}
+
+		constexpr int Find(std::string_view key) const
+		{
+			int index = m_Slots[Slot(key, m_Seed)];
+			return index != NotFound && m_Keys[index] == key ? index : NotFound;
+		}
+
+		//给switch的case用：case table.Index("name"):，key写错了就是编译错误
+		constexpr int Index(std::string_view key) const
+		{
+			int index = Find(key);
+			if (index == NotFound)
+				throw std::invalid_argument("PerfectHash: unknown key");
+			return index;
+		}
+
+		constexpr std::string_view Key(int index) const { return m_Keys[index]; }
+		constexpr size_t Size() const { return N; }
+
+	private:
+		//fmix64：每一位输入都会影响每一位输出
+		static constexpr uint64_t Mix(uint64_t hash)
+		{
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			hash *= 0xC4CEB9FE1A85EC53ull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		static constexpr size_t Slot(std::string_view key, uint64_t seed)
+		{
+			return TableBits == 0 ? 0 : (size_t)(Mix(Fnv1a(key, seed)) >> (64 - TableBits));
+		}
+
+		constexpr bool TryBuild(uint64_t seed)
+		{
+			for (int16_t& slot : m_Slots)
+				slot = NotFound;
+
+			for (size_t i = 0; i < N; i++)
+			{
+				int16_t& slot = m_Slots[Slot(m_Keys[i], seed)];
+				if (slot != NotFound)
+					return false;
+				slot = (int16_t)i;
+			}
+			m_Seed = seed;
+			return true;
+		}
+
+		std::array<std::string_view, N> m_Keys;
+		std::array<int16_t, TableSize> m_Slots = {};
+		uint64_t m_Seed = FnvOffsetBasis;
+	};
+
+	template<typename... Keys>
+	constexpr PerfectHash<sizeof...(Keys)> MakePerfectHash(Keys... keys)
+	{
+		return PerfectHash<sizeof...(Keys)>(std::array<std::string_view, sizeof...(Keys)>{ { keys... } });
+	}
+
+	//key → 处理函数的表，整个表在编译期建好。Dispatch对输入算一次哈希，找到就调用对应的函数
+	//  using Command = void (*)(Server&);
+	//  constexpr hash::StringSwitch<Command, 2> commands({ { { "start", Start }, { "stop", Stop } } });
+	//  if (!commands.Dispatch(input, server)) ...
+	template<typename Function, size_t N>
+	class StringSwitch
+	{
+	public:
+		constexpr explicit StringSwitch(const std::array<std::pair<std::string_view, Function>, N>& cases)
+			: m_Hash(KeysOf(cases)), m_Handlers(HandlersOf(cases))
+		{
+		}
+
+		//没有这个key返回false
+		template<typename... Args>
+		bool Dispatch(std::string_view key, Args&&... args) const
+		{
+			int index = m_Hash.Find(key);
+			if (index == PerfectHash<N>::NotFound)
+				return false;
+			m_Handlers[index](std::forward<Args>(args)...);
+			return true;
+		}
+
+		constexpr const PerfectHash<N>& Keys() const { return m_Hash; }
+
+	private:
+		static constexpr std::array<std::string_view, N> KeysOf(const std::array<std::pair<std::string_view, Function>, N>& cases)
+		{
+			std::array<std::string_view, N> keys = {};
+			for (size_t i = 0; i < N; i++)
+				keys[i] = cases[i].first;
+			return keys;
+		}
+
+		static constexpr std::array<Function, N> HandlersOf(const std::array<std::pair<std::string_view, Function>, N>& cases)
+		{
+			std::array<Function, N> handlers = {};
+			for (size_t i = 0; i < N; i++)
+				handlers[i] = cases[i].second;
+			return handlers;
+		}
+
+		PerfectHash<N> m_Hash;
+		std::array<Function, N> m_Handlers;
+	};
+}
@@ -1,10 +1,41 @@
 ﻿#include <iostream>
 #include <cstring>
+#include <string>
+
+#include "HashBenchmark.h"
+#include "StringHash.h"
+#include "Utf.h"
+#include "UtfBenchmark.h"
+
+namespace
+{
+	void Start(int& state) { state = 1; std::cout << "started" << std::endl; }
+	void Stop(int& state) { state = 0; std::cout << "stopped" << std::endl; }
+	void Status(int& state) { std::cout << (state ? "running" : "idle") << std::endl; }
+
+	//整张表（包括完美哈希的种子）在编译期就建好了
+	using Command = void (*)(int&);
+	constexpr hash::StringSwitch<Command, 3> s_Commands({ { { "start", Start }, { "stop", Stop }, { "status", Status } } });
+}
 
 //string literal
 //string literal is always in the const areas.
-int main()
+int main(int argc, char* argv[])
 {
+	//StringLiteral --utf：UTF-8/16/32转换和验证的吞吐量，逐个字符的写法 vs 标量/SSE4.1/AVX2
+	if (argc > 1 && std::string(argv[1]) == "--utf")
+	{
+		RunUtfBenchmark();
+		return 0;
+	}
+
+	//StringLiteral --hash：按字段名分发，一串strcmp vs unordered_map vs 编译期哈希的switch/完美哈希表
+	if (argc > 1 && std::string(argv[1]) == "--hash")
+	{
+		RunHashBenchmark();
+		return 0;
+	}
+
 	"Cherno";//const char* C h e r n o \0
 
 	const char name[8] = u8"Che\0rno"; // char = 1个字节
@@ -44,6 +75,25 @@ Line4)";
 	// Line2
 	// Line3
 
+	//上面几种字面量之间互相转换：转换时会检查编码是否合法，不合法抛std::range_error
+	std::string utf8 = u8"Cherno，你好 😀";
+	std::u16string utf16 = utf::ToUtf16(utf8);
+	std::u32string utf32 = utf::ToUtf32(utf8);
+	std::wstring wide = utf::ToWide(utf8);
+	std::cout << utf8.size() << " bytes of UTF-8, " << utf16.size() << " UTF-16 units, " << utf32.size() << " code points, "
+		<< wide.size() << " wchar_t; round trip ok: " << (utf::ToUtf8(utf16) == utf8 && utf::ToUtf8(wide) == utf8) << std::endl;
+	std::cout << "\"\\xC3\\x28\" is valid UTF-8: " << utf::ValidateUtf8("\xC3\x28", 2) << std::endl;
+
+	//字面量的哈希在编译期就算好了，运行时对输入只算一次哈希，然后查表跳转，不用一个一个strcmp
+	using namespace hash::literals;
+	static_assert("start"_hash == hash::Fnv1a("start"), "compile-time and run-time hashes must agree");
+	int state = 0;
+	for (const char* command : { "start", "status", "restart", "stop", "status" })
+	{
+		if (!s_Commands.Dispatch(command, state))
+			std::cout << "unknown command: " << command << std::endl;
+	}
+
 	std::cin.get();
 }
 
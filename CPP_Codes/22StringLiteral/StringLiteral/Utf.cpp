@@ -0,0 +1,1078 @@
+#include "Utf.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define UTF_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+//GCC/Clang要在函数上标明用到的指令集，整个文件仍然按基础指令集编译，老CPU照样能跑标量版本。MSVC不需要
+#if defined(_MSC_VER) && !defined(__clang__)
+#define UTF_TARGET_SSE4
+#define UTF_TARGET_AVX2
+#define UTF_INLINE __forceinline
+#else
+#define UTF_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define UTF_TARGET_AVX2 __attribute__((target("avx2")))
+#define UTF_INLINE __attribute__((always_inline)) inline
+#endif
+
+namespace utf
+{
+	namespace
+	{
+#pragma region scalar
+		//解码一个字符，返回用了几个单元，不合法返回0
+		UTF_INLINE size_t Decode(const char* in, size_t remaining, char32_t& codePoint)
+		{
+			const unsigned char* p = (const unsigned char*)in;
+			unsigned char lead = p[0];
+			if (lead < 0x80)
+			{
+				codePoint = lead;
+				return 1;
+			}
+			if (lead < 0xC2) //单独的后续字节，或者C0/C1开头的超长编码
+				return 0;
+			if (lead < 0xE0)
+			{
+				if (remaining < 2 || (p[1] & 0xC0) != 0x80)
+					return 0;
+				codePoint = ((lead & 0x1F) << 6) | (p[1] & 0x3F);
+				return 2;
+			}
+			if (lead < 0xF0)
+			{
+				if (remaining < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80)
+					return 0;
+				codePoint = ((lead & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+				if (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+					return 0;
+				return 3;
+			}
+			if (lead < 0xF5)
+			{
+				if (remaining < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80)
+					return 0;
+				codePoint = ((lead & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+				if (codePoint < 0x10000 || codePoint > 0x10FFFF)
+					return 0;
+				return 4;
+			}
+			return 0;
+		}
+
+		UTF_INLINE size_t Decode(const char16_t* in, size_t remaining, char32_t& codePoint)
+		{
+			char16_t unit = in[0];
+			if ((unit & 0xF800) != 0xD800)
+			{
+				codePoint = unit;
+				return 1;
+			}
+			//高代理项后面必须跟着低代理项
+			if (unit >= 0xDC00 || remaining < 2 || (in[1] & 0xFC00) != 0xDC00)
+				return 0;
+			codePoint = 0x10000 + (((char32_t)unit - 0xD800) << 10) + ((char32_t)in[1] - 0xDC00);
+			return 2;
+		}
+
+		UTF_INLINE size_t Decode(const char32_t* in, size_t, char32_t& codePoint)
+		{
+			codePoint = in[0];
+			if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+				return 0;
+			return 1;
+		}
+
+		//codePoint一定是合法的
+		UTF_INLINE size_t Encode(char32_t codePoint, char* out)
+		{
+			if (codePoint < 0x80)
+			{
+				out[0] = (char)codePoint;
+				return 1;
+			}
+			if (codePoint < 0x800)
+			{
+				out[0] = (char)(0xC0 | (codePoint >> 6));
+				out[1] = (char)(0x80 | (codePoint & 0x3F));
+				return 2;
+			}
+			if (codePoint < 0x10000)
+			{
+				out[0] = (char)(0xE0 | (codePoint >> 12));
+				out[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+				out[2] = (char)(0x80 | (codePoint & 0x3F));
+				return 3;
+			}
+			out[0] = (char)(0xF0 | (codePoint >> 18));
+			out[1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			out[2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			out[3] = (char)(0x80 | (codePoint & 0x3F));
+			return 4;
+		}
+
+		UTF_INLINE size_t Encode(char32_t codePoint, char16_t* out)
+		{
+			if (codePoint < 0x10000)
+			{
+				out[0] = (char16_t)codePoint;
+				return 1;
+			}
+			codePoint -= 0x10000;
+			out[0] = (char16_t)(0xD800 + (codePoint >> 10));
+			out[1] = (char16_t)(0xDC00 + (codePoint & 0x3FF));
+			return 2;
+		}
+
+		UTF_INLINE size_t Encode(char32_t codePoint, char32_t* out)
+		{
+			out[0] = codePoint;
+			return 1;
+		}
+
+		//SIMD遇到整块不能处理的数据之后，标量至少往前走这么多个单元再交回给SIMD
+		constexpr size_t ScalarRun = 16;
+
+		//SIMD整块转换了多少：读了几个输入单元、写了几个输出单元
+		struct Progress
+		{
+			size_t Read;
+			size_t Written;
+		};
+
+		//fast尽量整块转换，停下来的地方（有它处理不了的字符，或者剩下的不够一块）逐个字符解码、编码
+		template<typename In, typename Out>
+		size_t Transcode(const In* in, size_t size, Out* out, Progress (*fast)(const In*, size_t, Out*))
+		{
+			size_t i = 0;
+			size_t o = 0;
+			while (i < size)
+			{
+				size_t stop = size;
+				if (fast)
+				{
+					Progress progress = fast(in + i, size - i, out + o);
+					i += progress.Read;
+					o += progress.Written;
+					stop = std::min(size, i + ScalarRun);
+				}
+
+				while (i < stop)
+				{
+					char32_t codePoint;
+					size_t length = Decode(in + i, size - i, codePoint);
+					if (length == 0)
+						return Error;
+					i += length;
+					o += Encode(codePoint, out + o);
+				}
+			}
+			return o;
+		}
+
+		//同上，只检查不输出
+		template<typename In>
+		bool Validate(const In* in, size_t size, size_t (*fast)(const In*, size_t))
+		{
+			size_t i = 0;
+			while (i < size)
+			{
+				size_t stop = size;
+				if (fast)
+				{
+					i += fast(in + i, size - i);
+					stop = std::min(size, i + ScalarRun);
+				}
+
+				while (i < stop)
+				{
+					char32_t codePoint;
+					size_t length = Decode(in + i, size - i, codePoint);
+					if (length == 0)
+						return false;
+					i += length;
+				}
+			}
+			return true;
+		}
+
+		//ASCII一次跳过8个字节
+		bool ValidateUtf8Scalar(const char* data, size_t size)
+		{
+			size_t i = 0;
+			while (i < size)
+			{
+				uint64_t word;
+				if (i + 8 <= size && (memcpy(&word, data + i, 8), (word & 0x8080808080808080ull) == 0))
+				{
+					i += 8;
+					continue;
+				}
+
+				char32_t codePoint;
+				size_t length = Decode(data + i, size - i, codePoint);
+				if (length == 0)
+					return false;
+				i += length;
+			}
+			return true;
+		}
+#pragma endregion
+
+#if defined(UTF_X86)
+		//UTF-8验证的查找表：每个错误类型一个比特，
+		//第一个字节的高4位、第一个字节的低4位、第二个字节的高4位分别查一张表，三个结果AND起来不是0就是错误
+		constexpr uint8_t TooShort = 1 << 0;     //11______ 0_______ 或 11______ 11______：前导字节后面没有后续字节
+		constexpr uint8_t TooLong = 1 << 1;      //0_______ 10______：ASCII后面跟着后续字节
+		constexpr uint8_t Overlong3 = 1 << 2;    //11100000 100_____
+		constexpr uint8_t TooLarge = 1 << 3;     //11110100 1001____ 之类：大于U+10FFFF
+		constexpr uint8_t Surrogate = 1 << 4;    //11101101 101_____：U+D800~U+DFFF
+		constexpr uint8_t Overlong2 = 1 << 5;    //1100000_ 10______
+		constexpr uint8_t TooLarge1000 = 1 << 6; //11110101 1000____ 之类
+		constexpr uint8_t Overlong4 = 1 << 6;    //11110000 1000____，和TooLarge1000不会同时出现，共用一个比特
+		constexpr uint8_t TwoContinuations = 1 << 7; //10______ 10______：要另外看是不是3/4字节序列的中间
+		constexpr uint8_t Carry = TooShort | TooLong | TwoContinuations; //这几种和第一个字节的低4位无关
+
+		alignas(16) constexpr uint8_t Byte1High[16] = {
+			TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+			TwoContinuations, TwoContinuations, TwoContinuations, TwoContinuations,
+			TooShort | Overlong2,
+			TooShort,
+			TooShort | Overlong3 | Surrogate,
+			TooShort | TooLarge | TooLarge1000 | Overlong4,
+		};
+
+		alignas(16) constexpr uint8_t Byte1Low[16] = {
+			Carry | Overlong3 | Overlong2 | Overlong4,
+			Carry | Overlong2,
+			Carry,
+			Carry,
+			Carry | TooLarge,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000 | Surrogate,
+			Carry | TooLarge | TooLarge1000,
+			Carry | TooLarge | TooLarge1000,
+		};
+
+		alignas(16) constexpr uint8_t Byte2High[16] = {
+			TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+			TooLong | Overlong2 | TwoContinuations | Overlong3 | TooLarge1000 | Overlong4,
+			TooLong | Overlong2 | TwoContinuations | Overlong3 | TooLarge,
+			TooLong | Overlong2 | TwoContinuations | Surrogate | TooLarge,
+			TooLong | Overlong2 | TwoContinuations | Surrogate | TooLarge,
+			TooShort, TooShort, TooShort, TooShort,
+		};
+
+		//块的最后3个字节里如果有前导字节，它的后续字节在下一块里
+		alignas(16) constexpr uint8_t IncompleteLimit[16] = {
+			255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+		};
+
+#pragma region SSE4
+		struct Utf8StateSse4
+		{
+			__m128i Error;
+			__m128i Previous;
+			__m128i PreviousIncomplete;
+		};
+
+		UTF_TARGET_SSE4 UTF_INLINE __m128i HighNibbleSse4(__m128i bytes)
+		{
+			return _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F));
+		}
+
+		UTF_TARGET_SSE4 UTF_INLINE void CheckUtf8Sse4(Utf8StateSse4& state, __m128i input)
+		{
+			//整块都是ASCII：只要上一块没有留下没结束的序列就行
+			if (_mm_testz_si128(input, _mm_set1_epi8((char)0x80)))
+			{
+				state.Error = _mm_or_si128(state.Error, state.PreviousIncomplete);
+				return;
+			}
+
+			__m128i previous1 = _mm_alignr_epi8(input, state.Previous, 15);
+			__m128i byte1High = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)Byte1High), HighNibbleSse4(previous1));
+			__m128i byte1Low = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)Byte1Low), _mm_and_si128(previous1, _mm_set1_epi8(0x0F)));
+			__m128i byte2High = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)Byte2High), HighNibbleSse4(input));
+			__m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+			//前面第2个字节是111_____、或者前面第3个字节是1111____的位置必须是后续字节，正好对应TwoContinuations
+			__m128i previous2 = _mm_alignr_epi8(input, state.Previous, 14);
+			__m128i previous3 = _mm_alignr_epi8(input, state.Previous, 13);
+			__m128i third = _mm_subs_epu8(previous2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+			__m128i fourth = _mm_subs_epu8(previous3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+			__m128i mustContinue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+
+			state.Error = _mm_or_si128(state.Error, _mm_xor_si128(mustContinue, special));
+			state.PreviousIncomplete = _mm_subs_epu8(input, _mm_load_si128((const __m128i*)IncompleteLimit));
+			state.Previous = input;
+		}
+
+		UTF_TARGET_SSE4 bool ValidateUtf8Sse4(const char* data, size_t size)
+		{
+			Utf8StateSse4 state = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+				CheckUtf8Sse4(state, _mm_loadu_si128((const __m128i*)(data + i)));
+
+			//剩下的补0（当成ASCII）再查一块，顺便检查最后一个序列有没有被截断
+			alignas(16) char tail[16] = {};
+			memcpy(tail, data + i, size - i);
+			CheckUtf8Sse4(state, _mm_load_si128((const __m128i*)tail));
+			return _mm_testz_si128(state.Error, state.Error);
+		}
+
+		//把8个16位的值里mask选中的那些挤到前面
+		struct CompressTables
+		{
+			uint8_t Utf16[256][16];
+			uint8_t Utf16Count[256];
+			//4个32位的lane，每个lane里是1~3个UTF-8字节，下标是4个(字节数-1)，每个2位
+			uint8_t Utf8[256][16];
+			uint8_t Utf8Length[256];
+		};
+
+		constexpr CompressTables MakeCompressTables()
+		{
+			CompressTables tables = {};
+			for (int mask = 0; mask < 256; mask++)
+			{
+				int count = 0;
+				for (int lane = 0; lane < 8; lane++)
+				{
+					if (mask & (1 << lane))
+					{
+						tables.Utf16[mask][2 * count] = (uint8_t)(2 * lane);
+						tables.Utf16[mask][2 * count + 1] = (uint8_t)(2 * lane + 1);
+						count++;
+					}
+				}
+				for (int i = 2 * count; i < 16; i++)
+					tables.Utf16[mask][i] = 0x80;
+				tables.Utf16Count[mask] = (uint8_t)count;
+
+				int length = 0;
+				for (int lane = 0; lane < 4; lane++)
+				{
+					int bytes = ((mask >> (2 * lane)) & 3) + 1;
+					for (int i = 0; i < bytes && i < 3; i++)
+						tables.Utf8[mask][length++] = (uint8_t)(4 * lane + i);
+				}
+				for (int i = length; i < 16; i++)
+					tables.Utf8[mask][i] = 0x80;
+				tables.Utf8Length[mask] = (uint8_t)length;
+			}
+			return tables;
+		}
+
+		alignas(16) constexpr CompressTables s_Compress = MakeCompressTables();
+
+		UTF_INLINE unsigned int HighestBit(uint32_t mask)
+		{
+#if defined(_MSC_VER) && !defined(__clang__)
+			unsigned long index;
+			_BitScanReverse(&index, mask);
+			return (unsigned int)index;
+#else
+			return 31u - (unsigned int)__builtin_clz(mask);
+#endif
+		}
+
+		UTF_TARGET_SSE4 UTF_INLINE void StoreUnits(char16_t* out, __m128i units)
+		{
+			_mm_storeu_si128((__m128i*)out, units);
+		}
+
+		UTF_TARGET_SSE4 UTF_INLINE void StoreUnits(char32_t* out, __m128i units)
+		{
+			_mm_storeu_si128((__m128i*)out, _mm_cvtepu16_epi32(units));
+			_mm_storeu_si128((__m128i*)(out + 4), _mm_cvtepu16_epi32(_mm_srli_si128(units, 8)));
+		}
+
+		//8个字节位置，假设每个位置都是一个字符的开头，算出它的值（1~3字节的字符都不超过16位），不是开头的位置算出来的东西后面会被丢掉
+		UTF_TARGET_SSE4 UTF_INLINE __m128i DecodeLanesSse4(__m128i bytes0, __m128i bytes1, __m128i bytes2)
+		{
+			__m128i current = _mm_cvtepu8_epi16(bytes0);
+			__m128i next1 = _mm_and_si128(_mm_cvtepu8_epi16(bytes1), _mm_set1_epi16(0x3F));
+			__m128i next2 = _mm_and_si128(_mm_cvtepu8_epi16(bytes2), _mm_set1_epi16(0x3F));
+			__m128i two = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(current, _mm_set1_epi16(0x1F)), 6), next1);
+			__m128i three = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(current, 12), _mm_slli_epi16(next1, 6)), next2);
+			__m128i value = _mm_blendv_epi8(current, two, _mm_cmpgt_epi16(current, _mm_set1_epi16(0xBF)));
+			return _mm_blendv_epi8(value, three, _mm_cmpgt_epi16(current, _mm_set1_epi16(0xDF)));
+		}
+
+		//in[0]是一个字符的开头，in[0..17]都能读，输入已经验证过是合法的UTF-8。
+		//转换前16个字节里完整的字符（最后一个字符可能跨出去，留给下一次），有4字节的字符时不处理，返回false
+		template<typename Out>
+		UTF_TARGET_SSE4 UTF_INLINE bool Utf8StepSse4(const char* in, Out* out, Progress& progress)
+		{
+			__m128i bytes0 = _mm_loadu_si128((const __m128i*)in);
+			if (_mm_testz_si128(bytes0, _mm_set1_epi8((char)0x80)))
+			{
+				StoreUnits(out, _mm_cvtepu8_epi16(bytes0));
+				StoreUnits(out + 8, _mm_cvtepu8_epi16(_mm_srli_si128(bytes0, 8)));
+				progress = { 16, 16 };
+				return true;
+			}
+
+			__m128i fourByte = _mm_subs_epu8(bytes0, _mm_set1_epi8((char)0xEF));
+			if (!_mm_testz_si128(fourByte, fourByte))
+				return false;
+
+			//不是后续字节（10______，有符号时是-128~-65）的位置就是字符的开头；第16个字节也看一下，用来确定最后一个字符在哪里结束
+			uint32_t starts = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(bytes0, _mm_set1_epi8(-65)));
+			starts |= (uint32_t)((signed char)in[16] > -65) << 16;
+			unsigned int end = HighestBit(starts & 0x1FFFE);
+			uint32_t keep = starts & ((1u << end) - 1);
+
+			__m128i bytes1 = _mm_loadu_si128((const __m128i*)(in + 1));
+			__m128i bytes2 = _mm_loadu_si128((const __m128i*)(in + 2));
+			__m128i low = DecodeLanesSse4(bytes0, bytes1, bytes2);
+			__m128i high = DecodeLanesSse4(_mm_srli_si128(bytes0, 8), _mm_srli_si128(bytes1, 8), _mm_srli_si128(bytes2, 8));
+
+			uint32_t lowMask = keep & 0xFF;
+			uint32_t highMask = (keep >> 8) & 0xFF;
+			StoreUnits(out, _mm_shuffle_epi8(low, _mm_load_si128((const __m128i*)s_Compress.Utf16[lowMask])));
+			size_t written = s_Compress.Utf16Count[lowMask];
+			StoreUnits(out + written, _mm_shuffle_epi8(high, _mm_load_si128((const __m128i*)s_Compress.Utf16[highMask])));
+			written += s_Compress.Utf16Count[highMask];
+			progress = { end, written };
+			return true;
+		}
+
+		template<typename Out>
+		UTF_TARGET_SSE4 Progress Utf8ToUnitsSse4(const char* in, size_t size, Out* out)
+		{
+			Progress total = { 0, 0 };
+			Progress step;
+			while (total.Read + 18 <= size && Utf8StepSse4(in + total.Read, out + total.Written, step))
+			{
+				total.Read += step.Read;
+				total.Written += step.Written;
+			}
+			return total;
+		}
+
+		UTF_TARGET_SSE4 Progress Utf8ToUtf16Sse4(const char* in, size_t size, char16_t* out)
+		{
+			return Utf8ToUnitsSse4(in, size, out);
+		}
+
+		UTF_TARGET_SSE4 Progress Utf8ToUtf32Sse4(const char* in, size_t size, char32_t* out)
+		{
+			return Utf8ToUnitsSse4(in, size, out);
+		}
+
+		//4个BMP里的、不是代理项的码点编码成UTF-8，返回写了几个字节（写16个字节，后面的是垃圾）
+		UTF_TARGET_SSE4 UTF_INLINE size_t EncodeBmpSse4(__m128i codePoints, char* out)
+		{
+			__m128i oneByte = _mm_cmpgt_epi32(_mm_set1_epi32(0x80), codePoints);
+			__m128i twoBytes = _mm_cmpgt_epi32(_mm_set1_epi32(0x800), codePoints);
+			__m128i low6 = _mm_or_si128(_mm_and_si128(codePoints, _mm_set1_epi32(0x3F)), _mm_set1_epi32(0x80));
+			__m128i middle6 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(codePoints, 6), _mm_set1_epi32(0x3F)), _mm_set1_epi32(0x80));
+
+			//每个32位的lane里按顺序放1~3个字节
+			__m128i three = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(codePoints, 12), _mm_set1_epi32(0xE0)),
+				_mm_or_si128(_mm_slli_epi32(middle6, 8), _mm_slli_epi32(low6, 16)));
+			__m128i two = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(codePoints, 6), _mm_set1_epi32(0xC0)), _mm_slli_epi32(low6, 8));
+			__m128i bytes = _mm_blendv_epi8(_mm_blendv_epi8(three, two, twoBytes), codePoints, oneByte);
+
+			//字节数-1（0~2），4个lane各2位拼成表的下标
+			__m128i codes = _mm_add_epi32(_mm_add_epi32(_mm_set1_epi32(2), twoBytes), oneByte);
+			uint32_t packed = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(codes, codes), codes));
+			uint32_t index = (packed | (packed >> 6) | (packed >> 12) | (packed >> 18)) & 0xFF;
+
+			_mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(bytes, _mm_load_si128((const __m128i*)s_Compress.Utf8[index])));
+			return s_Compress.Utf8Length[index];
+		}
+
+		//8个UTF-16单元里有没有代理项（D800~DFFF）
+		UTF_TARGET_SSE4 UTF_INLINE bool HasSurrogateSse4(__m128i units)
+		{
+			__m128i masked = _mm_and_si128(units, _mm_set1_epi16((short)0xF800));
+			return _mm_movemask_epi8(_mm_cmpeq_epi16(masked, _mm_set1_epi16((short)0xD800))) != 0;
+		}
+
+		//in[0..15]都能读；16个ASCII一起转，否则转8个没有代理项的单元
+		UTF_TARGET_SSE4 UTF_INLINE bool Utf16StepSse4(const char16_t* in, char* out, Progress& progress)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)in);
+			__m128i b = _mm_loadu_si128((const __m128i*)(in + 8));
+			if (_mm_testz_si128(_mm_or_si128(a, b), _mm_set1_epi16((short)0xFF80)))
+			{
+				_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(a, b));
+				progress = { 16, 16 };
+				return true;
+			}
+			if (HasSurrogateSse4(a))
+				return false;
+
+			size_t written = EncodeBmpSse4(_mm_cvtepu16_epi32(a), out);
+			written += EncodeBmpSse4(_mm_cvtepu16_epi32(_mm_srli_si128(a, 8)), out + written);
+			progress = { 8, written };
+			return true;
+		}
+
+		//每次最多写28个字节，输出缓冲区有3*size，剩16个单元以上时一定放得下
+		UTF_TARGET_SSE4 Progress Utf16ToUtf8Sse4(const char16_t* in, size_t size, char* out)
+		{
+			Progress total = { 0, 0 };
+			Progress step;
+			while (total.Read + 16 <= size && Utf16StepSse4(in + total.Read, out + total.Written, step))
+			{
+				total.Read += step.Read;
+				total.Written += step.Written;
+			}
+			return total;
+		}
+
+		UTF_TARGET_SSE4 size_t PlainUtf16Sse4(const char16_t* in, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				if (HasSurrogateSse4(_mm_loadu_si128((const __m128i*)(in + i))))
+					break;
+			}
+			return i;
+		}
+
+		UTF_TARGET_SSE4 Progress Utf16ToUtf32Sse4(const char16_t* in, size_t size, char32_t* out)
+		{
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				__m128i units = _mm_loadu_si128((const __m128i*)(in + i));
+				if (HasSurrogateSse4(units))
+					break;
+				StoreUnits(out + i, units);
+			}
+			return { i, i };
+		}
+
+		//4个UTF-32单元里有没有不在BMP里的或者代理项（也就是不能直接当成一个UTF-16单元的）
+		UTF_TARGET_SSE4 UTF_INLINE bool HasNonBmpSse4(__m128i units)
+		{
+			__m128i surrogate = _mm_cmpeq_epi32(_mm_and_si128(units, _mm_set1_epi32((int)0xFFFFF800)), _mm_set1_epi32(0xD800));
+			__m128i bad = _mm_or_si128(surrogate, _mm_and_si128(units, _mm_set1_epi32((int)0xFFFF0000)));
+			return !_mm_testz_si128(bad, bad);
+		}
+
+		//in[0..15]都能读；16个ASCII一起转，否则转4个BMP里的码点
+		UTF_TARGET_SSE4 UTF_INLINE bool Utf32StepSse4(const char32_t* in, char* out, Progress& progress)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)in);
+			__m128i b = _mm_loadu_si128((const __m128i*)(in + 4));
+			__m128i c = _mm_loadu_si128((const __m128i*)(in + 8));
+			__m128i d = _mm_loadu_si128((const __m128i*)(in + 12));
+			if (_mm_testz_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), _mm_set1_epi32((int)0xFFFFFF80)))
+			{
+				_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d)));
+				progress = { 16, 16 };
+				return true;
+			}
+			if (HasNonBmpSse4(a))
+				return false;
+
+			progress = { 4, EncodeBmpSse4(a, out) };
+			return true;
+		}
+
+		UTF_TARGET_SSE4 Progress Utf32ToUtf8Sse4(const char32_t* in, size_t size, char* out)
+		{
+			Progress total = { 0, 0 };
+			Progress step;
+			while (total.Read + 16 <= size && Utf32StepSse4(in + total.Read, out + total.Written, step))
+			{
+				total.Read += step.Read;
+				total.Written += step.Written;
+			}
+			return total;
+		}
+
+		UTF_TARGET_SSE4 size_t ValidUtf32Sse4(const char32_t* in, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 4 <= size; i += 4)
+			{
+				__m128i units = _mm_loadu_si128((const __m128i*)(in + i));
+				__m128i surrogate = _mm_cmpeq_epi32(_mm_and_si128(units, _mm_set1_epi32((int)0xFFFFF800)), _mm_set1_epi32(0xD800));
+				__m128i tooLarge = _mm_xor_si128(_mm_max_epu32(units, _mm_set1_epi32(0x10FFFF)), _mm_set1_epi32(0x10FFFF));
+				__m128i bad = _mm_or_si128(surrogate, tooLarge);
+				if (!_mm_testz_si128(bad, bad))
+					break;
+			}
+			return i;
+		}
+
+		UTF_TARGET_SSE4 Progress Utf32ToUtf16Sse4(const char32_t* in, size_t size, char16_t* out)
+		{
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(in + i));
+				__m128i b = _mm_loadu_si128((const __m128i*)(in + i + 4));
+				if (HasNonBmpSse4(a) || HasNonBmpSse4(b))
+					break;
+				_mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi32(a, b));
+			}
+			return { i, i };
+		}
+#pragma endregion
+
+#pragma region AVX2
+		struct Utf8StateAvx2
+		{
+			__m256i Error;
+			__m256i Previous;
+			__m256i PreviousIncomplete;
+		};
+
+		UTF_TARGET_AVX2 UTF_INLINE __m256i LoadTableAvx2(const uint8_t* table)
+		{
+			return _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)table));
+		}
+
+		UTF_TARGET_AVX2 UTF_INLINE __m256i HighNibbleAvx2(__m256i bytes)
+		{
+			return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F));
+		}
+
+		//alignr是按128位的半边分别做的，先把上一块的高半边和这一块的低半边拼起来
+		template<int Count>
+		UTF_TARGET_AVX2 UTF_INLINE __m256i PreviousAvx2(__m256i input, __m256i previous)
+		{
+			return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - Count);
+		}
+
+		UTF_TARGET_AVX2 UTF_INLINE void CheckUtf8Avx2(Utf8StateAvx2& state, __m256i input)
+		{
+			if (_mm256_testz_si256(input, _mm256_set1_epi8((char)0x80)))
+			{
+				state.Error = _mm256_or_si256(state.Error, state.PreviousIncomplete);
+				return;
+			}
+
+			__m256i previous1 = PreviousAvx2<1>(input, state.Previous);
+			__m256i byte1High = _mm256_shuffle_epi8(LoadTableAvx2(Byte1High), HighNibbleAvx2(previous1));
+			__m256i byte1Low = _mm256_shuffle_epi8(LoadTableAvx2(Byte1Low), _mm256_and_si256(previous1, _mm256_set1_epi8(0x0F)));
+			__m256i byte2High = _mm256_shuffle_epi8(LoadTableAvx2(Byte2High), HighNibbleAvx2(input));
+			__m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+			__m256i third = _mm256_subs_epu8(PreviousAvx2<2>(input, state.Previous), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+			__m256i fourth = _mm256_subs_epu8(PreviousAvx2<3>(input, state.Previous), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+			__m256i mustContinue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+
+			state.Error = _mm256_or_si256(state.Error, _mm256_xor_si256(mustContinue, special));
+			//只有高半边的最后3个字节要看
+			__m256i limit = _mm256_inserti128_si256(_mm256_set1_epi8((char)255), _mm_load_si128((const __m128i*)IncompleteLimit), 1);
+			state.PreviousIncomplete = _mm256_subs_epu8(input, limit);
+			state.Previous = input;
+		}
+
+		UTF_TARGET_AVX2 bool ValidateUtf8Avx2(const char* data, size_t size)
+		{
+			Utf8StateAvx2 state = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+			size_t i = 0;
+			for (; i + 32 <= size; i += 32)
+				CheckUtf8Avx2(state, _mm256_loadu_si256((const __m256i*)(data + i)));
+
+			alignas(32) char tail[32] = {};
+			memcpy(tail, data + i, size - i);
+			CheckUtf8Avx2(state, _mm256_load_si256((const __m256i*)tail));
+			return _mm256_testz_si256(state.Error, state.Error);
+		}
+
+		//16个ASCII字节扩展成16个UTF-16/UTF-32单元
+		UTF_TARGET_AVX2 UTF_INLINE void StoreWide(char16_t* out, __m128i bytes)
+		{
+			_mm256_storeu_si256((__m256i*)out, _mm256_cvtepu8_epi16(bytes));
+		}
+
+		UTF_TARGET_AVX2 UTF_INLINE void StoreWide(char32_t* out, __m128i bytes)
+		{
+			_mm256_storeu_si256((__m256i*)out, _mm256_cvtepu8_epi32(bytes));
+			_mm256_storeu_si256((__m256i*)(out + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+		}
+
+		//AVX2一次检查32个单元是不是都是ASCII；不是的时候走上面SSE4.1的一步（内联进来，编译器会用VEX编码，不会有SSE/AVX切换的惩罚）
+		template<typename Out>
+		UTF_TARGET_AVX2 Progress Utf8ToUnitsAvx2(const char* in, size_t size, Out* out)
+		{
+			Progress total = { 0, 0 };
+			Progress step;
+			while (total.Read + 18 <= size)
+			{
+				if (total.Read + 32 <= size)
+				{
+					__m256i bytes = _mm256_loadu_si256((const __m256i*)(in + total.Read));
+					if (!_mm256_movemask_epi8(bytes))
+					{
+						__m128i low = _mm256_castsi256_si128(bytes);
+						__m128i high = _mm256_extracti128_si256(bytes, 1);
+						Out* destination = out + total.Written;
+						StoreWide(destination, low);
+						StoreWide(destination + 16, high);
+						total.Read += 32;
+						total.Written += 32;
+						continue;
+					}
+				}
+				if (!Utf8StepSse4(in + total.Read, out + total.Written, step))
+					break;
+				total.Read += step.Read;
+				total.Written += step.Written;
+			}
+			return total;
+		}
+
+		UTF_TARGET_AVX2 Progress Utf8ToUtf16Avx2(const char* in, size_t size, char16_t* out)
+		{
+			return Utf8ToUnitsAvx2(in, size, out);
+		}
+
+		UTF_TARGET_AVX2 Progress Utf8ToUtf32Avx2(const char* in, size_t size, char32_t* out)
+		{
+			return Utf8ToUnitsAvx2(in, size, out);
+		}
+
+		//pack是按128位的半边分别做的，结果里的64位块要重新排一下顺序
+		UTF_TARGET_AVX2 Progress Utf16ToUtf8Avx2(const char16_t* in, size_t size, char* out)
+		{
+			Progress total = { 0, 0 };
+			Progress step;
+			while (total.Read + 16 <= size)
+			{
+				if (total.Read + 32 <= size)
+				{
+					__m256i a = _mm256_loadu_si256((const __m256i*)(in + total.Read));
+					__m256i b = _mm256_loadu_si256((const __m256i*)(in + total.Read + 16));
+					if (_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_set1_epi16((short)0xFF80)))
+					{
+						_mm256_storeu_si256((__m256i*)(out + total.Written), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+						total.Read += 32;
+						total.Written += 32;
+						continue;
+					}
+				}
+				if (!Utf16StepSse4(in + total.Read, out + total.Written, step))
+					break;
+				total.Read += step.Read;
+				total.Written += step.Written;
+			}
+			return total;
+		}
+
+		UTF_TARGET_AVX2 Progress Utf32ToUtf8Avx2(const char32_t* in, size_t size, char* out)
+		{
+			Progress total = { 0, 0 };
+			Progress step;
+			while (total.Read + 16 <= size)
+			{
+				if (total.Read + 32 <= size)
+				{
+					const char32_t* source = in + total.Read;
+					__m256i a = _mm256_loadu_si256((const __m256i*)source);
+					__m256i b = _mm256_loadu_si256((const __m256i*)(source + 8));
+					__m256i c = _mm256_loadu_si256((const __m256i*)(source + 16));
+					__m256i d = _mm256_loadu_si256((const __m256i*)(source + 24));
+					if (_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d)), _mm256_set1_epi32((int)0xFFFFFF80)))
+					{
+						__m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+						_mm256_storeu_si256((__m256i*)(out + total.Written), _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+						total.Read += 32;
+						total.Written += 32;
+						continue;
+					}
+				}
+				if (!Utf32StepSse4(in + total.Read, out + total.Written, step))
+					break;
+				total.Read += step.Read;
+				total.Written += step.Written;
+			}
+			return total;
+		}
+
+		UTF_TARGET_AVX2 UTF_INLINE bool HasSurrogateAvx2(__m256i units)
+		{
+			__m256i masked = _mm256_and_si256(units, _mm256_set1_epi16((short)0xF800));
+			return _mm256_movemask_epi8(_mm256_cmpeq_epi16(masked, _mm256_set1_epi16((short)0xD800))) != 0;
+		}
+
+		UTF_TARGET_AVX2 size_t PlainUtf16Avx2(const char16_t* in, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+			{
+				if (HasSurrogateAvx2(_mm256_loadu_si256((const __m256i*)(in + i))))
+					break;
+			}
+			return i;
+		}
+
+		UTF_TARGET_AVX2 Progress Utf16ToUtf32Avx2(const char16_t* in, size_t size, char32_t* out)
+		{
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+			{
+				__m256i units = _mm256_loadu_si256((const __m256i*)(in + i));
+				if (HasSurrogateAvx2(units))
+					break;
+				_mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(units)));
+				_mm256_storeu_si256((__m256i*)(out + i + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(units, 1)));
+			}
+			return { i, i };
+		}
+
+		UTF_TARGET_AVX2 UTF_INLINE __m256i NotBmpAvx2(__m256i units)
+		{
+			__m256i surrogate = _mm256_cmpeq_epi32(_mm256_and_si256(units, _mm256_set1_epi32((int)0xFFFFF800)), _mm256_set1_epi32(0xD800));
+			return _mm256_or_si256(surrogate, _mm256_and_si256(units, _mm256_set1_epi32((int)0xFFFF0000)));
+		}
+
+		UTF_TARGET_AVX2 size_t ValidUtf32Avx2(const char32_t* in, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				__m256i units = _mm256_loadu_si256((const __m256i*)(in + i));
+				__m256i surrogate = _mm256_cmpeq_epi32(_mm256_and_si256(units, _mm256_set1_epi32((int)0xFFFFF800)), _mm256_set1_epi32(0xD800));
+				__m256i tooLarge = _mm256_xor_si256(_mm256_max_epu32(units, _mm256_set1_epi32(0x10FFFF)), _mm256_set1_epi32(0x10FFFF));
+				__m256i bad = _mm256_or_si256(surrogate, tooLarge);
+				if (!_mm256_testz_si256(bad, bad))
+					break;
+			}
+			return i;
+		}
+
+		UTF_TARGET_AVX2 Progress Utf32ToUtf16Avx2(const char32_t* in, size_t size, char16_t* out)
+		{
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+			{
+				__m256i a = _mm256_loadu_si256((const __m256i*)(in + i));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(in + i + 8));
+				__m256i bad = _mm256_or_si256(NotBmpAvx2(a), NotBmpAvx2(b));
+				if (!_mm256_testz_si256(bad, bad))
+					break;
+				_mm256_storeu_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8));
+			}
+			return { i, i };
+		}
+#pragma endregion
+#endif
+
+		//每套指令集整块处理的函数；标量版本没有整块的快速路径（nullptr），全部逐个字符处理
+		struct Kernels
+		{
+			InstructionSet Set;
+			bool (*ValidateUtf8)(const char*, size_t);
+			size_t (*PlainUtf16)(const char16_t*, size_t);
+			size_t (*ValidUtf32)(const char32_t*, size_t);
+			Progress (*Utf8ToUtf16)(const char*, size_t, char16_t*); //这两个假设输入已经验证过
+			Progress (*Utf8ToUtf32)(const char*, size_t, char32_t*);
+			Progress (*Utf16ToUtf8)(const char16_t*, size_t, char*);
+			Progress (*Utf16ToUtf32)(const char16_t*, size_t, char32_t*);
+			Progress (*Utf32ToUtf8)(const char32_t*, size_t, char*);
+			Progress (*Utf32ToUtf16)(const char32_t*, size_t, char16_t*);
+		};
+
+		const Kernels s_Scalar = { InstructionSet::Scalar, ValidateUtf8Scalar, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+#if defined(UTF_X86)
+		const Kernels s_Sse4 = { InstructionSet::Sse4, ValidateUtf8Sse4, PlainUtf16Sse4, ValidUtf32Sse4,
+			Utf8ToUtf16Sse4, Utf8ToUtf32Sse4, Utf16ToUtf8Sse4, Utf16ToUtf32Sse4, Utf32ToUtf8Sse4, Utf32ToUtf16Sse4 };
+		const Kernels s_Avx2 = { InstructionSet::Avx2, ValidateUtf8Avx2, PlainUtf16Avx2, ValidUtf32Avx2,
+			Utf8ToUtf16Avx2, Utf8ToUtf32Avx2, Utf16ToUtf8Avx2, Utf16ToUtf32Avx2, Utf32ToUtf8Avx2, Utf32ToUtf16Avx2 };
+#endif
+
+		const Kernels* Select(InstructionSet set)
+		{
+#if defined(UTF_X86)
+			if (set == InstructionSet::Avx2)
+				return &s_Avx2;
+			if (set == InstructionSet::Sse4)
+				return &s_Sse4;
+#else
+			(void)set;
+#endif
+			return &s_Scalar;
+		}
+
+		const Kernels*& Current()
+		{
+			static const Kernels* s_Current = Select(Detect());
+			return s_Current;
+		}
+
+		template<typename Result, typename In>
+		Result Convert(const In* in, size_t size, size_t capacity, size_t (*convert)(const In*, size_t, typename Result::value_type*))
+		{
+			Result result(capacity, 0);
+			size_t written = convert(in, size, result.data());
+			if (written == Error)
+				throw std::range_error("utf: invalid input");
+			result.resize(written);
+			return result;
+		}
+	}
+
+	InstructionSet Detect()
+	{
+#if defined(UTF_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+		//CPUID.1.ECX[19]是SSE4.1；AVX2还要OS保存YMM寄存器（OSXSAVE + XCR0的第1、2位）
+		int info[4];
+		__cpuid(info, 1);
+		bool sse41 = (info[2] & (1 << 19)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+			return InstructionSet::Avx2;
+		if (sse41)
+			return InstructionSet::Sse4;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return InstructionSet::Avx2;
+		if (__builtin_cpu_supports("sse4.1"))
+			return InstructionSet::Sse4;
+#endif
+#endif
+		return InstructionSet::Scalar;
+	}
+
+	InstructionSet Active()
+	{
+		return Current()->Set;
+	}
+
+	void SetInstructionSet(InstructionSet set)
+	{
+		if ((int)set > (int)Detect())
+			set = Detect();
+		Current() = Select(set);
+	}
+
+	const char* ToString(InstructionSet set)
+	{
+		switch (set)
+		{
+		case InstructionSet::Scalar: return "scalar";
+		case InstructionSet::Sse4: return "SSE4.1";
+		case InstructionSet::Avx2: return "AVX2";
+		}
+		return "?";
+	}
+
+	bool ValidateUtf8(const char* data, size_t size)
+	{
+		return Current()->ValidateUtf8(data, size);
+	}
+
+	bool ValidateUtf16(const char16_t* data, size_t size)
+	{
+		return Validate(data, size, Current()->PlainUtf16);
+	}
+
+	bool ValidateUtf32(const char32_t* data, size_t size)
+	{
+		return Validate(data, size, Current()->ValidUtf32);
+	}
+
+	//SIMD的多字节路径不检查编码，先整体验证一遍（比逐个字符检查快得多）；标量版本边转换边检查
+	size_t Utf8ToUtf16(const char* in, size_t size, char16_t* out)
+	{
+		const Kernels* kernels = Current();
+		if (kernels->Utf8ToUtf16 && !kernels->ValidateUtf8(in, size))
+			return Error;
+		return Transcode(in, size, out, kernels->Utf8ToUtf16);
+	}
+
+	size_t Utf8ToUtf32(const char* in, size_t size, char32_t* out)
+	{
+		const Kernels* kernels = Current();
+		if (kernels->Utf8ToUtf32 && !kernels->ValidateUtf8(in, size))
+			return Error;
+		return Transcode(in, size, out, kernels->Utf8ToUtf32);
+	}
+
+	size_t Utf16ToUtf8(const char16_t* in, size_t size, char* out)
+	{
+		return Transcode(in, size, out, Current()->Utf16ToUtf8);
+	}
+
+	size_t Utf16ToUtf32(const char16_t* in, size_t size, char32_t* out)
+	{
+		return Transcode(in, size, out, Current()->Utf16ToUtf32);
+	}
+
+	size_t Utf32ToUtf8(const char32_t* in, size_t size, char* out)
+	{
+		return Transcode(in, size, out, Current()->Utf32ToUtf8);
+	}
+
+	size_t Utf32ToUtf16(const char32_t* in, size_t size, char16_t* out)
+	{
+		return Transcode(in, size, out, Current()->Utf32ToUtf16);
+	}
+
+	std::u16string ToUtf16(std::string_view utf8)
+	{
+		return Convert<std::u16string>(utf8.data(), utf8.size(), utf8.size(), Utf8ToUtf16);
+	}
+
+	std::u32string ToUtf32(std::string_view utf8)
+	{
+		return Convert<std::u32string>(utf8.data(), utf8.size(), utf8.size(), Utf8ToUtf32);
+	}
+
+	std::string ToUtf8(std::u16string_view utf16)
+	{
+		return Convert<std::string>(utf16.data(), utf16.size(), 3 * utf16.size(), Utf16ToUtf8);
+	}
+
+	std::string ToUtf8(std::u32string_view utf32)
+	{
+		return Convert<std::string>(utf32.data(), utf32.size(), 4 * utf32.size(), Utf32ToUtf8);
+	}
+
+	std::wstring ToWide(std::string_view utf8)
+	{
+		std::wstring result(utf8.size(), 0);
+		size_t written;
+		if constexpr (sizeof(wchar_t) == sizeof(char16_t))
+			written = Utf8ToUtf16(utf8.data(), utf8.size(), (char16_t*)result.data());
+		else
+			written = Utf8ToUtf32(utf8.data(), utf8.size(), (char32_t*)result.data());
+		if (written == Error)
+			throw std::range_error("utf: invalid input");
+		result.resize(written);
+		return result;
+	}
+
+	std::string ToUtf8(std::wstring_view wide)
+	{
+		if constexpr (sizeof(wchar_t) == sizeof(char16_t))
+			return ToUtf8(std::u16string_view((const char16_t*)wide.data(), wide.size()));
+		else
+			return ToUtf8(std::u32string_view((const char32_t*)wide.data(), wide.size()));
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+//UTF-8 / UTF-16 / UTF-32之间互相转换，转换的同时检查输入是不是合法的编码：
+//超长编码（overlong）、单独的代理项（surrogate）、大于U+10FFFF、截断的序列都算错误。
+//
+//第一次调用时检测CPU，选AVX2 > SSE4.1 > 标量。SIMD版本做的事：
+//  - UTF-8验证：每次16/32个字节，用三张16项的查找表判断相邻字节的组合是否合法（Keiser & Lemire的算法）
+//  - 转换：整块是ASCII时直接扩展/压缩；1~3字节的字符（西欧文字、俄文、中日韩文……）每个位置都按"如果这里是字符开头"解码，
+//    再用查找表把真正的字符开头挤到一起。4字节的字符（emoji等）和UTF-16的代理对逐个解码。
+//  - UTF-8输入先整体用SIMD验证，之后的SIMD转换就不用再检查了
+namespace utf
+{
+	enum class InstructionSet
+	{
+		Scalar, Sse4, Avx2
+	};
+
+	inline constexpr size_t Error = (size_t)-1;
+
+	bool ValidateUtf8(const char* data, size_t size);
+	bool ValidateUtf16(const char16_t* data, size_t size);
+	bool ValidateUtf32(const char32_t* data, size_t size);
+
+	//返回写了多少个单元，输入不合法时返回Error（这时out里已经写了一部分）。
+	//out至少要能放下：UTF-8→16/32：size个；UTF-16→8：3*size；UTF-16→32：size；UTF-32→8：4*size；UTF-32→16：2*size
+	size_t Utf8ToUtf16(const char* in, size_t size, char16_t* out);
+	size_t Utf8ToUtf32(const char* in, size_t size, char32_t* out);
+	size_t Utf16ToUtf8(const char16_t* in, size_t size, char* out);
+	size_t Utf16ToUtf32(const char16_t* in, size_t size, char32_t* out);
+	size_t Utf32ToUtf8(const char32_t* in, size_t size, char* out);
+	size_t Utf32ToUtf16(const char32_t* in, size_t size, char16_t* out);
+
+	//方便用的版本：不合法时抛std::range_error（和std::wstring_convert一样）
+	std::u16string ToUtf16(std::string_view utf8);
+	std::u32string ToUtf32(std::string_view utf8);
+	std::string ToUtf8(std::u16string_view utf16);
+	std::string ToUtf8(std::u32string_view utf32);
+
+	//wchar_t在Windows上是UTF-16，在Linux上是UTF-32
+	std::wstring ToWide(std::string_view utf8);
+	std::string ToUtf8(std::wstring_view wide);
+
+	InstructionSet Detect();                //CPU支持的最好的
+	InstructionSet Active();                //现在正在用的
+	void SetInstructionSet(InstructionSet); //给benchmark用：强制用某一套（高于CPU支持的会被降下来）。不是线程安全的
+	const char* ToString(InstructionSet set);
+}
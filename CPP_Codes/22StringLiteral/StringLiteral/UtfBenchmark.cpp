@@ -0,0 +1,223 @@
+﻿#include "UtfBenchmark.h"
+#include "Utf.h"
+
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	//常见的写法：看前导字节决定长度，再一个一个检查后续字节，每个字符都走一遍所有的分支
+	size_t NaiveDecode(const unsigned char* p, size_t remaining, char32_t& codePoint)
+	{
+		size_t length;
+		if (p[0] < 0x80)
+		{
+			codePoint = p[0];
+			return 1;
+		}
+		else if ((p[0] & 0xE0) == 0xC0)
+		{
+			length = 2;
+			codePoint = p[0] & 0x1F;
+		}
+		else if ((p[0] & 0xF0) == 0xE0)
+		{
+			length = 3;
+			codePoint = p[0] & 0x0F;
+		}
+		else if ((p[0] & 0xF8) == 0xF0)
+		{
+			length = 4;
+			codePoint = p[0] & 0x07;
+		}
+		else
+		{
+			return 0;
+		}
+
+		if (length > remaining)
+			return 0;
+		for (size_t i = 1; i < length; i++)
+		{
+			if ((p[i] & 0xC0) != 0x80)
+				return 0;
+			codePoint = (codePoint << 6) | (p[i] & 0x3F);
+		}
+
+		static const char32_t minimum[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if (codePoint < minimum[length] || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+			return 0;
+		return length;
+	}
+
+	bool NaiveValidateUtf8(const char* data, size_t size)
+	{
+		for (size_t i = 0; i < size;)
+		{
+			char32_t codePoint;
+			size_t length = NaiveDecode((const unsigned char*)data + i, size - i, codePoint);
+			if (length == 0)
+				return false;
+			i += length;
+		}
+		return true;
+	}
+
+	size_t NaiveUtf8ToUtf16(const char* in, size_t size, char16_t* out)
+	{
+		size_t o = 0;
+		for (size_t i = 0; i < size;)
+		{
+			char32_t codePoint;
+			size_t length = NaiveDecode((const unsigned char*)in + i, size - i, codePoint);
+			if (length == 0)
+				return utf::Error;
+			i += length;
+			if (codePoint < 0x10000)
+			{
+				out[o++] = (char16_t)codePoint;
+			}
+			else
+			{
+				out[o++] = (char16_t)(0xD800 + ((codePoint - 0x10000) >> 10));
+				out[o++] = (char16_t)(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+			}
+		}
+		return o;
+	}
+
+	size_t NaiveUtf16ToUtf8(const char16_t* in, size_t size, char* out)
+	{
+		size_t o = 0;
+		for (size_t i = 0; i < size; i++)
+		{
+			char32_t codePoint = in[i];
+			if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+			{
+				if (codePoint >= 0xDC00 || i + 1 >= size || in[i + 1] < 0xDC00 || in[i + 1] > 0xDFFF)
+					return utf::Error;
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (in[++i] - 0xDC00);
+			}
+
+			if (codePoint < 0x80)
+			{
+				out[o++] = (char)codePoint;
+			}
+			else if (codePoint < 0x800)
+			{
+				out[o++] = (char)(0xC0 | (codePoint >> 6));
+				out[o++] = (char)(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				out[o++] = (char)(0xE0 | (codePoint >> 12));
+				out[o++] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+				out[o++] = (char)(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				out[o++] = (char)(0xF0 | (codePoint >> 18));
+				out[o++] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+				out[o++] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+				out[o++] = (char)(0x80 | (codePoint & 0x3F));
+			}
+		}
+		return o;
+	}
+
+	//大约size字节的UTF-8文本：单词由alphabet里的字符组成，单词之间是空格，每行80个字符左右
+	std::string MakeText(const std::u32string& alphabet, size_t size)
+	{
+		std::mt19937 random(42);
+		std::u32string text;
+		std::string utf8;
+		while (utf8.size() < size)
+		{
+			text.clear();
+			for (int column = 0; column < 80; column++)
+				text += random() % 6 == 0 ? U' ' : alphabet[random() % alphabet.size()];
+			text += U'\n';
+			utf8 += utf::ToUtf8(text);
+		}
+		return utf8;
+	}
+
+	template<typename Fn>
+	double GigabytesPerSecond(const std::string& name, size_t bytes, Fn&& fn)
+	{
+		benchmark::Options options;
+		options.WarmupRuns = 1;
+		options.Samples = 5;
+		options.MinSampleNanoseconds = 5'000'000;
+		return bytes / benchmark::Run(name, fn, options).Median; //字节/纳秒 = GB/s
+	}
+}
+
+void RunUtfBenchmark()
+{
+	struct Text
+	{
+		const char* Name;
+		std::u32string Alphabet;
+	};
+	const Text texts[] = {
+		{ "ASCII", U"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,;" },
+		{ "Latin", U"abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzéèàçôü" },
+		{ "Cyrillic", U"абвгдеёжзийклмнопрстуфхцчшщъыьэюя" },
+		{ "CJK", U"的一是不了人我在有他这中大来上国个到说们为子和你地出道也时年得就那要下以生会自着去之过家学对可她里后小么心多天而能好都然没日于起还发成事只作当想看文无开手十用主行前所本见经头面公同三已老从动两长知民样现分将外但身些与高意进把法此实回二理美点月明" },
+		{ "Emoji", U"😀😁😂🤣😃😄😅😆😉😊😋😎😍😘🥰😗🙂🤗🤩🤔🤨😐😑😶🙄😏😣😥😮🤐😯😪😫🥱😴😌😛😜😝🤤" },
+	};
+	const utf::InstructionSet sets[] = { utf::InstructionSet::Scalar, utf::InstructionSet::Sse4, utf::InstructionSet::Avx2 };
+	const utf::InstructionSet detected = utf::Detect();
+
+	std::cout << "UTF transcoding, GB/s of input (CPU supports " << utf::ToString(detected) << ")" << std::endl;
+	std::cout << std::left << std::setw(24) << "operation" << std::right << std::setw(10) << "naive";
+	for (utf::InstructionSet set : sets)
+		std::cout << std::setw(10) << utf::ToString(set);
+	std::cout << std::endl;
+
+	auto print = [&](const std::string& name, double naive, const std::vector<double>& results)
+	{
+		std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2) << std::setw(10) << naive;
+		for (double result : results)
+			std::cout << std::setw(10) << result;
+		std::cout << std::endl;
+		std::cout.unsetf(std::ios::floatfield);
+	};
+
+	for (const Text& text : texts)
+	{
+		std::string utf8 = MakeText(text.Alphabet, 1 << 20);
+		std::u16string utf16 = utf::ToUtf16(utf8);
+		std::vector<char16_t> out16(utf8.size());
+		std::vector<char> out8(3 * utf16.size());
+		size_t bytes16 = utf16.size() * sizeof(char16_t);
+
+		std::vector<double> validate, toUtf16, toUtf8;
+		for (utf::InstructionSet set : sets)
+		{
+			utf::SetInstructionSet(set);
+			bool available = utf::Active() == set;
+			validate.push_back(!available ? 0.0 : GigabytesPerSecond("validate", utf8.size(),
+				[&]() { benchmark::DoNotOptimize(utf::ValidateUtf8(utf8.data(), utf8.size())); }));
+			toUtf16.push_back(!available ? 0.0 : GigabytesPerSecond("utf8->utf16", utf8.size(),
+				[&]() { benchmark::DoNotOptimize(utf::Utf8ToUtf16(utf8.data(), utf8.size(), out16.data())); benchmark::ClobberMemory(); }));
+			toUtf8.push_back(!available ? 0.0 : GigabytesPerSecond("utf16->utf8", bytes16,
+				[&]() { benchmark::DoNotOptimize(utf::Utf16ToUtf8(utf16.data(), utf16.size(), out8.data())); benchmark::ClobberMemory(); }));
+		}
+		utf::SetInstructionSet(detected);
+
+		print(std::string(text.Name) + " validate", GigabytesPerSecond("naive validate", utf8.size(),
+			[&]() { benchmark::DoNotOptimize(NaiveValidateUtf8(utf8.data(), utf8.size())); }), validate);
+		print(std::string(text.Name) + " utf8->utf16", GigabytesPerSecond("naive utf8->utf16", utf8.size(),
+			[&]() { benchmark::DoNotOptimize(NaiveUtf8ToUtf16(utf8.data(), utf8.size(), out16.data())); benchmark::ClobberMemory(); }), toUtf16);
+		print(std::string(text.Name) + " utf16->utf8", GigabytesPerSecond("naive utf16->utf8", bytes16,
+			[&]() { benchmark::DoNotOptimize(NaiveUtf16ToUtf8(utf16.data(), utf16.size(), out8.data())); benchmark::ClobberMemory(); }), toUtf8);
+	}
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+//每种文本（纯ASCII、大部分ASCII的西欧文字、俄文、中文、emoji）各1MB，
+//比较"常见的逐个字符写法"和utf里标量/SSE4.1/AVX2三套实现的吞吐量（输入的GB/s）
+void RunUtfBenchmark();
@@ -1,4 +1,10 @@
 ﻿#include <iostream>
+#include <string>
+#include <utility>
+
+#include "CowString.h"
+#include "String.h"
+#include "StringBenchmark.h"
 
 #pragma region wide copy
 //class String
@@ -60,51 +66,59 @@
 #pragma endregion
 
 #pragma region deep copy
-class String
-{
-private:
-    char* m_Buffer;
-    unsigned int m_Size;
-public:
-    String(const char* string)
-    {
-        m_Size = strlen(string);
-        m_Buffer = new char[m_Size + 1];
-
-        /*for (int i = 0; i < m_Size; i++)
-            m_Buffer[i] = string[i];*/
-        memcpy(m_Buffer, string, m_Size);
-        m_Buffer[m_Size] = 0;
-    }
-
-    //String(const String& other) : m_Buffer(other.m_Buffer),m_Size(other.m_Size){ } //C++默认提供的拷贝构造函数 
-    String(const String& other) :m_Size(other.m_Size)
-    {
-        m_Buffer = new char[m_Size + 1];
-        memcpy(m_Buffer, other.m_Buffer, m_Size + 1);//other已经是一个字符串看，必须要终止字符，所以我们拷贝size+1的大小。
-    }
-
-    ~String()
-    {
-        delete[] m_Buffer;
-    }
+//class String
+//{
+//private:
+//    char* m_Buffer;
+//    unsigned int m_Size;
+//public:
+//    String(const char* string)
+//    {
+//        m_Size = strlen(string);
+//        m_Buffer = new char[m_Size + 1];
+//
+//        /*for (int i = 0; i < m_Size; i++)
+//            m_Buffer[i] = string[i];*/
+//        memcpy(m_Buffer, string, m_Size);
+//        m_Buffer[m_Size] = 0;
+//    }
+//
+//    //String(const String& other) : m_Buffer(other.m_Buffer),m_Size(other.m_Size){ } //C++默认提供的拷贝构造函数 
+//    String(const String& other) :m_Size(other.m_Size)
+//    {
+//        m_Buffer = new char[m_Size + 1];
+//        memcpy(m_Buffer, other.m_Buffer, m_Size + 1);//other已经是一个字符串看，必须要终止字符，所以我们拷贝size+1的大小。
+//    }
+//
+//    ~String()
+//    {
+//        delete[] m_Buffer;
+//    }
+//
+//    char& operator[](unsigned int index)
+//    {
+//        return m_Buffer[index];
+//    }
+//
+//    friend std::ostream& operator<<(std::ostream& stream, const String& string);
+//};
+//
+//std::ostream& operator<<(std::ostream& stream, const String& string)
+//{
+//    stream << string.m_Buffer;
+//    return stream;
+//}
+//String现在在String.h里：同样的深拷贝，加了短字符串优化，"Cherno"这种短字符串不再new
 
-    char& operator[](unsigned int index)
+int main(int argc, char* argv[])
+{
+    //CopyConstructor --alloc：有没有移动构造、放不放在MonotonicArena里，往vector里放一百万个String各要分配多少次
+    if (argc > 1 && std::string(argv[1]) == "--alloc")
     {
-        return m_Buffer[index];
+        RunStringBenchmark();
+        return 0;
     }
 
-    friend std::ostream& operator<<(std::ostream& stream, const String& string);
-};
-
-std::ostream& operator<<(std::ostream& stream, const String& string)
-{
-    stream << string.m_Buffer;
-    return stream;
-}
-
-int main()
-{
     String string = "Cherno";
     std::cout << string << std::endl;
 
@@ -116,6 +130,25 @@ int main()
     std::cout << string << std::endl;//Charno
     std::cout << second << std::endl;//Cherno
 
+    String longer = "a string that does not fit inline";
+    std::cout << "sizeof(String) = " << sizeof(String) << ", \"" << second << "\" inline: " << second.IsInline()
+        << ", \"" << longer << "\" inline: " << longer.IsInline() << std::endl;
+
+    String moved = std::move(longer);//不分配：堆上的缓冲区直接换了主人
+    second = moved;//拷贝赋值（copy-and-swap）
+    std::cout << second << std::endl;
+
+    //写时复制：8个消费者拿到的是同一块缓冲区，拷贝只是引用计数+1
+    CowString payload = "a large read-mostly payload shared by every consumer";
+    CowString consumers[8] = { payload, payload, payload, payload, payload, payload, payload, payload };
+    std::cout << "shared by " << payload.UseCount() << ", first char " << std::as_const(consumers[0])[0] << std::endl;//const访问不复制（非const的[]会当作要写，复制出一份）
+    CowString& writer = consumers[3];
+    writer[0] = 'A';//要写了才复制出自己的一份
+    std::cout << writer << " (use count " << writer.UseCount() << "), others still shared by " << payload.UseCount() << std::endl;
+
+    std::cout << "\"" << moved << "\" contains \"inline\" at " << moved.Find("inline")
+        << ", equals ignoring case: " << moved.EqualsIgnoreCase("A STRING THAT DOES NOT FIT INLINE") << std::endl;
+
     std::cin.get();
 }
 //深拷贝，程序不会出异常
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <utility>
+
+//写时复制（copy-on-write）的字符串：拷贝时不复制字符，只是多一个人引用同一块缓冲区（引用计数是原子的，可以跨线程拷贝/析构）。
+//只读的访问（const的operator[]、Data()、Size()、<<）永远不会复制；
+//只有通过非const的operator[]写的时候，如果缓冲区还有别人在用，才复制出自己的一份（detach）。
+//一大块只读数据发给很多个消费者时，每次拷贝都是O(1)。
+//
+//非const的operator[]返回的引用可能被留着以后再写，所以调用过它的缓冲区会被标记为不可共享，之后的拷贝都是深拷贝。
+class CowString
+{
+public:
+    CowString(const char* string)
+        : m_Buffer(Allocate(string, (unsigned int)strlen(string)))
+    {
+    }
+
+    CowString(const CowString& other)
+        : m_Buffer(other.m_Buffer && other.m_Buffer->Shareable ? Share(other.m_Buffer) : Allocate(other.Data(), other.Size()))
+    {
+    }
+
+    CowString(CowString&& other) noexcept
+        : m_Buffer(std::exchange(other.m_Buffer, nullptr))
+    {
+    }
+
+    ~CowString()
+    {
+        Release(m_Buffer);
+    }
+
+    CowString& operator=(const CowString& other)
+    {
+        CowString copy(other);
+        swap(*this, copy);
+        return *this;
+    }
+
+    CowString& operator=(CowString&& other) noexcept
+    {
+        CowString moved(std::move(other));
+        swap(*this, moved);
+        return *this;
+    }
+
+    friend void swap(CowString& a, CowString& b) noexcept
+    {
+        std::swap(a.m_Buffer, b.m_Buffer);
+    }
+
+    //被移动走的对象没有缓冲区，按空字符串处理：[0]是结尾的'\0'
+    const char& operator[](unsigned int index) const
+    {
+        return Data()[index];
+    }
+
+    //写之前先确保缓冲区只属于自己
+    char& operator[](unsigned int index)
+    {
+        Detach();
+        m_Buffer->Shareable = false;
+        return m_Buffer->Data[index];
+    }
+
+    const char* Data() const { return m_Buffer ? m_Buffer->Data : ""; }
+    unsigned int Size() const { return m_Buffer ? m_Buffer->Size : 0; }
+
+    //有几个CowString在共享这块缓冲区
+    unsigned int UseCount() const { return m_Buffer ? m_Buffer->RefCount.load(std::memory_order_relaxed) : 0; }
+
+    friend std::ostream& operator<<(std::ostream& stream, const CowString& string);
+
+private:
+    //头部和字符放在同一次分配里
+    struct Buffer
+    {
+        std::atomic<unsigned int> RefCount;
+        unsigned int Size;
+        bool Shareable;
+        char Data[1];
+    };
+
+    static Buffer* Allocate(const char* string, unsigned int size)
+    {
+        void* memory = ::operator new(offsetof(Buffer, Data) + size + 1);
+        Buffer* buffer = new (memory) Buffer;
+        buffer->RefCount.store(1, std::memory_order_relaxed);
+        buffer->Size = size;
+        buffer->Shareable = true;
+        memcpy(buffer->Data, string, size);
+        buffer->Data[size] = 0;
+        return buffer;
+    }
+
+    //多一个引用不需要和任何写操作同步：拷贝的人本来就已经能看到这块缓冲区
+    static Buffer* Share(Buffer* buffer)
+    {
+        buffer->RefCount.fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    //最后一个释放的人要看到其他人对缓冲区的所有访问都已经结束，所以是acq_rel
+    static void Release(Buffer* buffer)
+    {
+        if (buffer && buffer->RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            buffer->~Buffer();
+            ::operator delete(buffer);
+        }
+    }
+
+    void Detach()
+    {
+        if (!m_Buffer)
+        {
+            m_Buffer = Allocate("", 0);
+            return;
+        }
+        if (m_Buffer->RefCount.load(std::memory_order_acquire) == 1)
+            return;
+
+        Buffer* unique = Allocate(m_Buffer->Data, m_Buffer->Size);
+        Release(m_Buffer);
+        m_Buffer = unique;
+    }
+
+    Buffer* m_Buffer; //被移动走之后是nullptr，当作空字符串
+};
+
+inline std::ostream& operator<<(std::ostream& stream, const CowString& string)
+{
+    stream << string.Data();
+    return stream;
+}
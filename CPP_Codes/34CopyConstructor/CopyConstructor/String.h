@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+
+#if !defined(_MSC_VER)
+#include <strings.h>
+#endif
+
+//短字符串优化（SSO）：对象本身24字节，最多22个字符直接存在对象里，不用new；更长的才去堆上分配。
+//最后一个字节是标记：短字符串时是长度（0~22），长字符串时是HeapTag。
+//
+//  短：[ 22个字符 + '\0' ][长度]
+//  长：[ char* Data ][ Size ][ Capacity ][ 填充 ][HeapTag]
+//
+//两种布局里都没有指向自己的指针，所以移动和swap就是搬24个字节：长字符串的堆内存换了主人，不分配也不拷贝字符。
+//移动和swap都是noexcept，std::vector<String>扩容时会移动而不是拷贝。
+//
+//长字符串的内存通过Allocator分配（和std::basic_string一样是allocator-aware的）：
+//  String                  std::allocator，空类，借空基类优化不占空间，对象还是24字节
+//  pmr::String             std::pmr::polymorphic_allocator，多存一个memory_resource*，比如放进MonotonicArena，
+//                          一个请求里的所有字符串在arena.Reset()时一起回收，不用一个一个delete[]
+//和标准容器一样，拷贝构造用select_on_container_copy_construction（pmr的拷贝回到默认资源），
+//赋值不换allocator：两边allocator不相等时移动赋值会退化成拷贝。
+template<typename Allocator>
+class BasicString : private Allocator
+{
+    using Traits = std::allocator_traits<Allocator>;
+
+public:
+    using allocator_type = Allocator; //有了它，std::pmr::vector<pmr::String>会把自己的memory_resource传给元素
+
+    static constexpr unsigned int InlineCapacity = 22;
+
+    BasicString(const char* string, const Allocator& allocator = Allocator())
+        : Allocator(allocator)
+    {
+        Assign(string, (unsigned int)strlen(string));
+    }
+
+    //深拷贝：短字符串只是把24个字节拷过去
+    BasicString(const BasicString& other)
+        : BasicString(other, Traits::select_on_container_copy_construction(other.GetAllocator()))
+    {
+    }
+
+    BasicString(const BasicString& other, const Allocator& allocator)
+        : Allocator(allocator)
+    {
+        Assign(other.Data(), other.Size());
+    }
+
+    //把other的24个字节整个拿过来，other变回空字符串
+    BasicString(BasicString&& other) noexcept
+        : Allocator(std::move(other.GetAllocator()))
+    {
+        Steal(other);
+    }
+
+    //allocator不同时不能直接拿走other的堆内存（得用自己的allocator释放），只能拷贝
+    BasicString(BasicString&& other, const Allocator& allocator)
+        : Allocator(allocator)
+    {
+        if (other.IsInline() || GetAllocator() == other.GetAllocator())
+            Steal(other);
+        else
+            Assign(other.Data(), other.Size());
+    }
+
+    ~BasicString()
+    {
+        Free();
+    }
+
+    //copy-and-swap：先用自己的allocator拷贝出一个临时对象（可能抛bad_alloc，这时*this不受影响），再和它交换，旧内容随临时对象析构
+    BasicString& operator=(const BasicString& other)
+    {
+        BasicString copy(other, GetAllocator());
+        swap(*this, copy);
+        return *this;
+    }
+
+    BasicString& operator=(BasicString&& other) noexcept(Traits::is_always_equal::value)
+    {
+        if constexpr (Traits::is_always_equal::value)
+        {
+            BasicString moved(std::move(other));
+            swap(*this, moved);
+        }
+        else
+        {
+            BasicString moved(std::move(other), GetAllocator());
+            swap(*this, moved);
+        }
+        return *this;
+    }
+
+    //只交换24个字节：两边的allocator必须相等（和标准容器的要求一样）
+    friend void swap(BasicString& a, BasicString& b) noexcept
+    {
+        char temp[sizeof(Inline)];
+        memcpy(temp, &a.m_Inline, sizeof(temp));
+        memcpy(&a.m_Inline, &b.m_Inline, sizeof(temp));
+        memcpy(&b.m_Inline, temp, sizeof(temp));
+    }
+
+    Allocator GetAllocator() const { return *this; }
+
+    char& operator[](unsigned int index)
+    {
+        return Data()[index];
+    }
+
+    const char& operator[](unsigned int index) const
+    {
+        return Data()[index];
+    }
+
+    unsigned int Size() const { return IsInline() ? m_Inline.Size : m_Heap.Size; }
+    bool IsInline() const { return m_Inline.Size != HeapTag; }
+
+    char* Data() { return IsInline() ? m_Inline.Buffer : m_Heap.Data; }
+    const char* Data() const { return IsInline() ? m_Inline.Buffer : m_Heap.Data; }
+
+    static constexpr size_t NotFound = (size_t)-1;
+
+    //查找/比较用C库：glibc和MSVC的CRT本身就是按CPU选的向量化实现
+    size_t Find(const char* needle) const
+    {
+        return std::string_view(Data(), Size()).find(needle);
+    }
+
+    size_t Find(char byte) const
+    {
+        const char* found = (const char*)memchr(Data(), byte, Size());
+        return found ? (size_t)(found - Data()) : NotFound;
+    }
+
+    bool operator==(const BasicString& other) const
+    {
+        return Size() == other.Size() && memcmp(Data(), other.Data(), Size()) == 0;
+    }
+
+    bool operator!=(const BasicString& other) const
+    {
+        return !(*this == other);
+    }
+
+    bool EqualsIgnoreCase(const BasicString& other) const
+    {
+#if defined(_MSC_VER)
+        return Size() == other.Size() && _strnicmp(Data(), other.Data(), Size()) == 0;
+#else
+        return Size() == other.Size() && strncasecmp(Data(), other.Data(), Size()) == 0;
+#endif
+    }
+
+    friend std::ostream& operator<<(std::ostream& stream, const BasicString& string)
+    {
+        stream << string.Data();
+        return stream;
+    }
+
+private:
+    static constexpr unsigned char HeapTag = 0xFF;
+
+    struct Inline
+    {
+        char Buffer[InlineCapacity + 1];
+        unsigned char Size;
+    };
+
+    struct Heap
+    {
+        char* Data;
+        unsigned int Size;
+        unsigned int Capacity;
+        char Padding[sizeof(Inline) - sizeof(char*) - 2 * sizeof(unsigned int) - 1];
+        unsigned char Tag; //和Inline::Size是同一个字节
+    };
+
+    static_assert(sizeof(Inline) == 24 && sizeof(Heap) == 24, "both layouts must be 24 bytes with the tag in the last byte");
+
+    void Assign(const char* string, unsigned int size)
+    {
+        if (size <= InlineCapacity)
+        {
+            memcpy(m_Inline.Buffer, string, size);
+            m_Inline.Buffer[size] = 0;
+            m_Inline.Size = (unsigned char)size;
+        }
+        else
+        {
+            m_Heap.Data = Traits::allocate(*this, size + 1);
+            memcpy(m_Heap.Data, string, size);
+            m_Heap.Data[size] = 0;
+            m_Heap.Size = size;
+            m_Heap.Capacity = size;
+            m_Heap.Tag = HeapTag;
+        }
+    }
+
+    void Steal(BasicString& other)
+    {
+        memcpy(&m_Inline, &other.m_Inline, sizeof(m_Inline));
+        other.m_Inline.Buffer[0] = 0;
+        other.m_Inline.Size = 0;
+    }
+
+    void Free()
+    {
+        if (!IsInline())
+            Traits::deallocate(*this, m_Heap.Data, m_Heap.Capacity + 1);
+    }
+
+    union
+    {
+        Inline m_Inline;
+        Heap m_Heap;
+    };
+};
+
+using String = BasicString<std::allocator<char>>;
+
+namespace pmr
+{
+    using String = BasicString<std::pmr::polymorphic_allocator<char>>;
+}
+
+static_assert(sizeof(String) == 24, "std::allocator is empty and must not make String bigger");
@@ -0,0 +1,90 @@
+#include "StringBenchmark.h"
+#include "String.h"
+
+#include "AllocationCounter.h"
+#include "Arena.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+//声明了拷贝构造，编译器就不会再生成移动构造：右值也只能走拷贝
+struct CopyOnlyString : String
+{
+    using String::String;
+
+    CopyOnlyString(const CopyOnlyString& other) : String(other) {}
+    CopyOnlyString& operator=(const CopyOnlyString& other)
+    {
+        String::operator=(other);
+        return *this;
+    }
+};
+
+template<typename StringType>
+static StringBenchmarkResult Measure(const char* name, unsigned int count)
+{
+    benchmark::ScopedAllocationCounting counting;
+    benchmark::AllocationCounts before = benchmark::ThreadAllocations();
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<StringType> strings;
+        for (unsigned int i = 0; i < count; i++)
+            strings.push_back(StringType("this key is longer than twenty-two characters"));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    StringBenchmarkResult result;
+    result.Name = name;
+    benchmark::AllocationCounts after = benchmark::ThreadAllocations();
+    result.Allocations = after.Count - before.Count;
+    result.Bytes = after.Bytes - before.Bytes;
+    result.Milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    return result;
+}
+
+//vector和每个字符串都从arena里分配，用完了Reset()一次，而不是一百万次delete[]
+static StringBenchmarkResult MeasureArena(const char* name, unsigned int count)
+{
+    benchmark::ScopedAllocationCounting counting;
+    benchmark::AllocationCounts before = benchmark::ThreadAllocations();
+    auto start = std::chrono::steady_clock::now();
+    MonotonicArena arena(64 * 1024);
+    {
+        std::pmr::vector<pmr::String> strings(&arena);
+        for (unsigned int i = 0; i < count; i++)
+            strings.emplace_back("this key is longer than twenty-two characters");
+    }
+    arena.Reset();
+    auto end = std::chrono::steady_clock::now();
+
+    StringBenchmarkResult result;
+    result.Name = name;
+    benchmark::AllocationCounts after = benchmark::ThreadAllocations();
+    result.Allocations = after.Count - before.Count;
+    result.Bytes = after.Bytes - before.Bytes;
+    result.Milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    return result;
+}
+
+std::vector<StringBenchmarkResult> RunStringBenchmark(unsigned int count)
+{
+    std::vector<StringBenchmarkResult> results;
+    results.push_back(Measure<CopyOnlyString>("copy only", count));
+    results.push_back(Measure<String>("move", count));
+    results.push_back(MeasureArena("arena", count));
+
+    std::cout << count << " x push_back(String(45 chars)) into std::vector" << std::endl;
+    std::cout << std::left << std::setw(12) << "String" << std::right << std::setw(14) << "allocations"
+        << std::setw(14) << "MB" << std::setw(12) << "ms" << std::endl;
+    for (const StringBenchmarkResult& result : results)
+    {
+        std::cout << std::left << std::setw(12) << result.Name << std::right << std::setw(14) << result.Allocations
+            << std::fixed << std::setprecision(1) << std::setw(14) << result.Bytes / (1024.0 * 1024.0)
+            << std::setw(12) << result.Milliseconds << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    }
+    return results;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//往std::vector里push_back一百万个String（都超过22个字符，一定在堆上），数operator new被调用了多少次。
+//"copy only"是只有拷贝构造的String（加移动构造之前的样子）：临时对象进vector要拷贝一次，vector扩容时每个元素再拷贝一次。
+//"arena"是pmr::String放在MonotonicArena里：只有arena向堆要大块内存的那几次。
+struct StringBenchmarkResult
+{
+    const char* Name;
+    uint64_t Allocations;
+    uint64_t Bytes;
+    double Milliseconds;
+};
+
+std::vector<StringBenchmarkResult> RunStringBenchmark(unsigned int count = 1'000'000);
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//单调（monotonic）分配器：手里有一块内存和一个指针，分配就是把指针往后挪（对齐一下），和在栈上开变量差不多便宜。
+//单个对象不释放（deallocate什么都不做），一批对象用完之后Reset()一次性全部还回去，而不是一个一个delete。
+//当前这块用完了就从上游（默认是new/delete）再要一块更大的，用链表串起来。
+//可以先给一块栈上的缓冲区，小的请求整个过程都不碰堆。
+//
+//继承std::pmr::memory_resource，所以std::pmr::vector、std::pmr::string和allocator-aware的String都可以直接用它。
+//不是线程安全的：一般是每个请求/每帧/每个线程一个。
+class MonotonicArena : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t DefaultChunkSize = 4096;
+
+    explicit MonotonicArena(size_t chunkSize = DefaultChunkSize, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_Upstream(upstream), m_NextChunkSize(std::max(chunkSize, sizeof(Chunk) + alignof(std::max_align_t)))
+    {
+    }
+
+    //先用buffer（不归arena管，要活得比arena长），用完了再找上游要
+    MonotonicArena(void* buffer, size_t size, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : MonotonicArena(std::max(size, DefaultChunkSize), upstream)
+    {
+        m_InitialBuffer = (char*)buffer;
+        m_InitialSize = size;
+        m_Current = m_InitialBuffer;
+        m_End = m_InitialBuffer + size;
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() override
+    {
+        Release();
+    }
+
+    //arena里分配的所有东西一次作废：保留最大的一块下次接着用，其余的还给上游。
+    //只是把指针挪回去，不调用析构函数，所以arena里的对象要么是平凡析构的，要么自己在Reset之前析构
+    void Reset()
+    {
+        if (m_Spare)
+        {
+            m_Spare->Next = m_Chunks;
+            m_Chunks = m_Spare;
+            m_Spare = nullptr;
+        }
+
+        Chunk* keep = m_Chunks;
+        if (keep)
+        {
+            for (Chunk* chunk = keep->Next; chunk; chunk = chunk->Next)
+            {
+                if (chunk->Size > keep->Size)
+                    keep = chunk;
+            }
+        }
+
+        Chunk* chunk = m_Chunks;
+        while (chunk)
+        {
+            Chunk* next = chunk->Next;
+            if (chunk != keep)
+                m_Upstream->deallocate(chunk, chunk->Size, alignof(std::max_align_t));
+            chunk = next;
+        }
+
+        m_BytesAllocated = 0;
+        if (m_InitialBuffer)
+        {
+            //栈上的缓冲区还是最先用，keep留着等它用完
+            m_Chunks = nullptr;
+            m_Spare = keep;
+            m_Current = m_InitialBuffer;
+            m_End = m_InitialBuffer + m_InitialSize;
+        }
+        else if (keep)
+        {
+            keep->Next = nullptr;
+            m_Chunks = keep;
+            m_Current = keep->Data();
+            m_End = (char*)keep + keep->Size;
+        }
+        else
+        {
+            m_Current = m_End = nullptr;
+        }
+    }
+
+    //在arena里构造一个对象，不用delete，Reset()时内存一起回收
+    template<typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Reset() does not run destructors");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    size_t BytesAllocated() const { return m_BytesAllocated; } //上次Reset之后分出去了多少字节（不算对齐的空隙）
+
+    size_t ChunkCount() const
+    {
+        size_t count = m_Spare ? 1 : 0;
+        for (Chunk* chunk = m_Chunks; chunk; chunk = chunk->Next)
+            count++;
+        return count;
+    }
+
+    std::pmr::memory_resource* Upstream() const { return m_Upstream; }
+
+private:
+    //每块从上游要来的内存开头放一个Chunk，后面才是分配出去的空间
+    struct alignas(std::max_align_t) Chunk
+    {
+        Chunk* Next;
+        size_t Size; //包括Chunk本身
+
+        char* Data() { return (char*)(this + 1); }
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        char* aligned = Align(m_Current, alignment);
+        if (!aligned || aligned > m_End || bytes > (size_t)(m_End - aligned))
+        {
+            Grow(bytes, alignment);
+            aligned = Align(m_Current, alignment);
+        }
+        m_Current = aligned + bytes;
+        m_BytesAllocated += bytes;
+        return aligned;
+    }
+
+    //单个对象不回收
+    void do_deallocate(void*, size_t, size_t) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static char* Align(char* pointer, size_t alignment)
+    {
+        if (!pointer)
+            return nullptr;
+        uintptr_t address = ((uintptr_t)pointer + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        return (char*)address;
+    }
+
+    //每次要的块是上一次的两倍，分配次数是O(log 总字节数)；一次要很多的请求单独给一块刚好够的
+    void Grow(size_t bytes, size_t alignment)
+    {
+        size_t needed = sizeof(Chunk) + bytes + (alignment > alignof(std::max_align_t) ? alignment : 0);
+
+        Chunk* chunk;
+        if (m_Spare && m_Spare->Size >= needed)
+        {
+            chunk = m_Spare;
+            m_Spare = nullptr;
+        }
+        else
+        {
+            size_t size = std::max(m_NextChunkSize, needed);
+            chunk = (Chunk*)m_Upstream->allocate(size, alignof(std::max_align_t));
+            chunk->Size = size;
+            m_NextChunkSize = std::max(m_NextChunkSize, size) * 2;
+        }
+
+        chunk->Next = m_Chunks;
+        m_Chunks = chunk;
+        m_Current = chunk->Data();
+        m_End = (char*)chunk + chunk->Size;
+    }
+
+    void Release()
+    {
+        if (m_Spare)
+            m_Upstream->deallocate(m_Spare, m_Spare->Size, alignof(std::max_align_t));
+        m_Spare = nullptr;
+        Chunk* chunk = m_Chunks;
+        while (chunk)
+        {
+            Chunk* next = chunk->Next;
+            m_Upstream->deallocate(chunk, chunk->Size, alignof(std::max_align_t));
+            chunk = next;
+        }
+        m_Chunks = nullptr;
+    }
+
+    std::pmr::memory_resource* m_Upstream;
+    size_t m_NextChunkSize;
+    Chunk* m_Chunks = nullptr; //最新的在前面
+    Chunk* m_Spare = nullptr;  //有栈上缓冲区时，Reset留下来的那一块先放在这里
+    char* m_Current = nullptr;
+    char* m_End = nullptr;
+    char* m_InitialBuffer = nullptr;
+    size_t m_InitialSize = 0;
+    size_t m_BytesAllocated = 0;
+};
+
+//自带一块Size字节栈上缓冲区的arena：放在函数里当局部变量，装得下的话整个过程一次堆分配都没有
+template<size_t Size>
+class StackArena : public MonotonicArena
+{
+public:
+    explicit StackArena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : MonotonicArena(m_Buffer, Size, upstream)
+    {
+    }
+
+private:
+    alignas(std::max_align_t) char m_Buffer[Size];
+};
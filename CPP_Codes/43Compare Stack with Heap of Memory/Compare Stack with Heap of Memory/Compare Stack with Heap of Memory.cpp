@@ -1,4 +1,8 @@
-﻿#include <iostream>
+﻿#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "Arena.h"
 
 //stack:预定义的一个内存区域，通常为2M字节大小,RAM中
 //heap:也是一个预定义的内存区域，RAM中
@@ -19,6 +23,37 @@ int main()
     int* hArray = new int[5];//heap
     Vector3* hVector = new Vector3();//heap
 
+    //同样的三个对象放在arena里：只是把指针往后挪，不用delete，arena.Reset()时一起回收
+    StackArena<256> arena;
+    int* aValue = arena.New<int>(5);
+    int* aArray = (int*)arena.allocate(5 * sizeof(int), alignof(int));
+    Vector3* aVector = arena.New<Vector3>();
+    std::cout << "arena: " << arena.BytesAllocated() << " bytes, " << arena.ChunkCount() << " heap chunks, "
+        << *aValue << " " << (void*)aArray << " " << aVector->x << std::endl;
+
+    //一个"请求"里new出来的2000个短命的小对象：逐个new/delete vs arena里分配、请求结束Reset一次
+    const int requests = 2000, objects = 2000;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Vector3*> pointers(objects);
+    for (int request = 0; request < requests; request++)
+    {
+        for (int i = 0; i < objects; i++)
+            pointers[i] = new Vector3{ (float)i, 0.0f, 0.0f };
+        for (int i = 0; i < objects; i++)
+            delete pointers[i];
+    }
+    auto middle = std::chrono::steady_clock::now();
+    MonotonicArena requestArena;
+    for (int request = 0; request < requests; request++)
+    {
+        for (int i = 0; i < objects; i++)
+            pointers[i] = requestArena.New<Vector3>(Vector3{ (float)i, 0.0f, 0.0f });
+        requestArena.Reset();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "new/delete: " << std::chrono::duration<double, std::milli>(middle - start).count() << "ms, arena: "
+        << std::chrono::duration<double, std::milli>(end - middle).count() << "ms" << std::endl;
+
     std::cin.get();
 }
 //stack的分配与释放，没有任何开销，不需要回退指针并返回指针地址。
@@ -27,4 +62,5 @@ int main()
 //通过malloc函数请求分配时，会调用底层的特定功能，浏览free list，
 //返回一个满足条件的内存空间的指针。
 //并记录一些相关信息，比如这块内存被占用，无法再被分配给其他程序等等。
+//Arena.h里的MonotonicArena介于两者之间：先从堆上要一大块，之后的分配像栈一样只挪指针，用完一次性还回去。
 
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <utility>
+
+//固定容量的无锁环形队列。
+//MpmcQueue：多生产者多消费者，Dmitry Vyukov的做法——每个槽一个序号，生产者/消费者各自CAS抢位置，抢到后只碰自己那个槽。
+//SpscQueue：一个生产者一个消费者，连CAS都不要，只有两个各自只被一个线程写的下标。
+//Try*不阻塞，满/空时返回false；Push/Pop满/空时先自旋一会儿，再在atomic::wait上睡（C++20，Linux上是futex）。
+//下标和槽都按cache line对齐，生产者和消费者不会因为写相邻的变量互相让对方的cache line失效。
+//T需要能默认构造和移动赋值（Pop用一个空的T接结果）。
+namespace queue_detail
+{
+	//std::hardware_destructive_interference_size在各编译器上的支持不一致，直接用x86的64
+	inline constexpr size_t CacheLineSize = 64;
+
+	inline size_t RoundUpToPowerOfTwo(size_t value)
+	{
+		size_t result = 1;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+
+	//自旋几十次后开始yield，再等就在值上睡
+	template<typename Value>
+	void WaitWhileEqual(const std::atomic<Value>& atomic, Value old)
+	{
+		for (int spin = 0; spin < 64; spin++)
+		{
+			if (atomic.load(std::memory_order_acquire) != old)
+				return;
+			if (spin >= 32)
+				std::this_thread::yield();
+		}
+		atomic.wait(old, std::memory_order_acquire);
+	}
+}
+
+template<typename T>
+class MpmcQueue
+{
+public:
+	//容量向上取到2的幂
+	explicit MpmcQueue(size_t capacity)
+		: m_Capacity(queue_detail::RoundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)), m_Mask(m_Capacity - 1),
+		m_Cells(new Cell[m_Capacity])
+	{
+		for (size_t i = 0; i < m_Capacity; i++)
+			m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	~MpmcQueue()
+	{
+		T value;
+		while (TryPop(value))
+		{
+		}
+		delete[] m_Cells;
+	}
+
+	MpmcQueue(const MpmcQueue&) = delete;
+	MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+	size_t Capacity() const { return m_Capacity; }
+
+	template<typename U>
+	bool TryPush(U&& value)
+	{
+		size_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = m_Cells[position & m_Mask];
+			size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+			if (difference == 0)
+			{
+				//槽是空的，抢这个位置
+				if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					Store(cell, position, std::forward<U>(value));
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				//槽里还是上一圈的数据：满了
+				return false;
+			}
+			else
+			{
+				//别的生产者已经抢走了这个位置
+				position = m_EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool TryPop(T& value)
+	{
+		size_t position = m_DequeuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = m_Cells[position & m_Mask];
+			size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+			if (difference == 0)
+			{
+				if (m_DequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					Load(cell, position, value);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false; //空
+			}
+			else
+			{
+				position = m_DequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	//阻塞版直接fetch_add领一个位置（不会失败、不用CAS重试），然后等这个槽轮到自己
+	template<typename U>
+	void Push(U&& value)
+	{
+		size_t position = m_EnqueuePosition.fetch_add(1, std::memory_order_relaxed);
+		Cell& cell = m_Cells[position & m_Mask];
+		size_t sequence;
+		while ((sequence = cell.Sequence.load(std::memory_order_acquire)) != position)
+			queue_detail::WaitWhileEqual(cell.Sequence, sequence);
+		Store(cell, position, std::forward<U>(value));
+	}
+
+	T Pop()
+	{
+		size_t position = m_DequeuePosition.fetch_add(1, std::memory_order_relaxed);
+		Cell& cell = m_Cells[position & m_Mask];
+		size_t sequence;
+		while ((sequence = cell.Sequence.load(std::memory_order_acquire)) != position + 1)
+			queue_detail::WaitWhileEqual(cell.Sequence, sequence);
+
+		T value;
+		Load(cell, position, value);
+		return value;
+	}
+
+private:
+	struct alignas(queue_detail::CacheLineSize) Cell
+	{
+		std::atomic<size_t> Sequence;
+		alignas(T) unsigned char Storage[sizeof(T)];
+	};
+
+	template<typename U>
+	void Store(Cell& cell, size_t position, U&& value)
+	{
+		new (cell.Storage) T(std::forward<U>(value));
+		cell.Sequence.store(position + 1, std::memory_order_release);
+		cell.Sequence.notify_all();
+	}
+
+	void Load(Cell& cell, size_t position, T& value)
+	{
+		T* stored = std::launder(reinterpret_cast<T*>(cell.Storage));
+		value = std::move(*stored);
+		stored->~T();
+		//下一圈的生产者在position + capacity时用这个槽
+		cell.Sequence.store(position + m_Capacity, std::memory_order_release);
+		cell.Sequence.notify_all();
+	}
+
+	const size_t m_Capacity;
+	const size_t m_Mask;
+	Cell* const m_Cells;
+
+	alignas(queue_detail::CacheLineSize) std::atomic<size_t> m_EnqueuePosition{ 0 };
+	alignas(queue_detail::CacheLineSize) std::atomic<size_t> m_DequeuePosition{ 0 };
+};
+
+template<typename T>
+class SpscQueue
+{
+public:
+	explicit SpscQueue(size_t capacity)
+		: m_Capacity(queue_detail::RoundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)), m_Mask(m_Capacity - 1),
+		m_Slots(new Slot[m_Capacity])
+	{
+	}
+
+	~SpscQueue()
+	{
+		T value;
+		while (TryPop(value))
+		{
+		}
+		delete[] m_Slots;
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	size_t Capacity() const { return m_Capacity; }
+
+	//只能在生产者线程调用
+	template<typename U>
+	bool TryPush(U&& value)
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		//先看自己缓存的head，真的像是满了才去读消费者那边的cache line
+		if (tail - m_CachedHead == m_Capacity)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (tail - m_CachedHead == m_Capacity)
+				return false;
+		}
+
+		new (m_Slots[tail & m_Mask].Storage) T(std::forward<U>(value));
+		m_Tail.store(tail + 1, std::memory_order_release);
+		m_Tail.notify_one();
+		return true;
+	}
+
+	//只能在消费者线程调用
+	bool TryPop(T& value)
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (head == m_CachedTail)
+				return false;
+		}
+
+		T* stored = std::launder(reinterpret_cast<T*>(m_Slots[head & m_Mask].Storage));
+		value = std::move(*stored);
+		stored->~T();
+		m_Head.store(head + 1, std::memory_order_release);
+		m_Head.notify_one();
+		return true;
+	}
+
+	template<typename U>
+	void Push(U&& value)
+	{
+		while (!TryPush(std::forward<U>(value)))
+			queue_detail::WaitWhileEqual(m_Head, m_CachedHead);
+	}
+
+	T Pop()
+	{
+		T value;
+		while (!TryPop(value))
+			queue_detail::WaitWhileEqual(m_Tail, m_CachedTail);
+		return value;
+	}
+
+private:
+	struct Slot
+	{
+		alignas(T) unsigned char Storage[sizeof(T)];
+	};
+
+	const size_t m_Capacity;
+	const size_t m_Mask;
+	Slot* const m_Slots;
+
+	//消费者写的
+	alignas(queue_detail::CacheLineSize) std::atomic<size_t> m_Head{ 0 };
+	size_t m_CachedTail = 0;
+	//生产者写的
+	alignas(queue_detail::CacheLineSize) std::atomic<size_t> m_Tail{ 0 };
+	size_t m_CachedHead = 0;
+};
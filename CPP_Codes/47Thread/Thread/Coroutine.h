@@ -0,0 +1,601 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "ThreadPool.h"
+
+//C++20协程跑在ThreadPool上：一个逻辑任务只是一个堆上的协程帧（几百字节），不是一个线程（一个栈就是MB级）。
+//
+//	coro::Task<int> Work(ThreadPool& pool, int i)
+//	{
+//		co_await coro::ScheduleOn(pool);                 //切到池里的线程
+//		co_await coro::SleepFor(pool, 10ms);             //不占线程地等，到点后在池里继续
+//		co_return i;
+//	}
+//	std::vector<coro::Task<int>> tasks; ...
+//	std::vector<int> results = coro::SyncWait(coro::WhenAll(std::move(tasks)));
+//
+//Task是惰性的：co_await它（或SyncWait）时才开始跑，跑完通过对称转移直接恢复等待它的协程，不经过队列。
+//所以想并行就在子任务开头co_await ScheduleOn(pool)。
+namespace coro
+{
+	template<typename T = void>
+	class Task;
+
+	namespace detail
+	{
+		struct PromiseBase
+		{
+			std::coroutine_handle<> Continuation;
+			std::exception_ptr Exception;
+
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+
+				template<typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					std::coroutine_handle<> continuation = handle.promise().Continuation;
+					return continuation ? continuation : std::noop_coroutine();
+				}
+
+				void await_resume() noexcept {}
+			};
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			FinalAwaiter final_suspend() noexcept { return {}; }
+			void unhandled_exception() { Exception = std::current_exception(); }
+		};
+
+		template<typename T>
+		struct Promise : PromiseBase
+		{
+			std::optional<T> Value;
+
+			Task<T> get_return_object();
+
+			template<typename U>
+			void return_value(U&& value) { Value.emplace(std::forward<U>(value)); }
+
+			T Result()
+			{
+				if (Exception)
+					std::rethrow_exception(Exception);
+				return std::move(*Value);
+			}
+		};
+
+		template<>
+		struct Promise<void> : PromiseBase
+		{
+			Task<void> get_return_object();
+
+			void return_void() {}
+
+			void Result()
+			{
+				if (Exception)
+					std::rethrow_exception(Exception);
+			}
+		};
+
+		//开始就跑、跑完自己销毁，用来在WhenAll/WhenAny/SyncWait里驱动子任务
+		struct DetachedTask
+		{
+			struct promise_type
+			{
+				DetachedTask get_return_object() { return {}; }
+				std::suspend_never initial_suspend() noexcept { return {}; }
+				std::suspend_never final_suspend() noexcept { return {}; }
+				void return_void() {}
+				void unhandled_exception() { std::terminate(); }
+			};
+		};
+
+		//void结果在容器里用monostate占位
+		template<typename T>
+		using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+	}
+
+	template<typename T>
+	class Task
+	{
+	public:
+		using promise_type = detail::Promise<T>;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task() = default;
+		explicit Task(Handle handle) : m_Handle(handle) {}
+
+		Task(Task&& other) noexcept
+			: m_Handle(std::exchange(other.m_Handle, {}))
+		{
+		}
+
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_Handle)
+					m_Handle.destroy();
+				m_Handle = std::exchange(other.m_Handle, {});
+			}
+			return *this;
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (m_Handle)
+				m_Handle.destroy();
+		}
+
+		bool IsReady() const { return !m_Handle || m_Handle.done(); }
+
+		auto operator co_await() noexcept
+		{
+			struct Awaiter
+			{
+				Handle Coroutine;
+
+				bool await_ready() noexcept { return !Coroutine || Coroutine.done(); }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					Coroutine.promise().Continuation = awaiting;
+					return Coroutine;
+				}
+
+				T await_resume() { return Coroutine.promise().Result(); }
+			};
+			return Awaiter{ m_Handle };
+		}
+
+	private:
+		Handle m_Handle;
+	};
+
+	namespace detail
+	{
+		template<typename T>
+		Task<T> Promise<T>::get_return_object() { return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this)); }
+
+		inline Task<void> Promise<void>::get_return_object() { return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this)); }
+	}
+
+	//co_await ScheduleOn(pool)之后，协程剩下的部分在pool的线程上跑
+	inline auto ScheduleOn(ThreadPool& pool)
+	{
+		struct Awaiter
+		{
+			ThreadPool& Pool;
+
+			bool await_ready() noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { Pool.Post([handle]() { handle.resume(); }); }
+			void await_resume() noexcept {}
+		};
+		return Awaiter{ pool };
+	}
+
+	//一个线程管所有定时器：到点后把协程Post回它的池。等待期间协程不占任何线程。
+	//定时器里记着池的指针，所以池必须活得比在上面睡觉的协程久：不再需要的定时器用Cancel（或者SleepFor的stop_token）撤掉，
+	//撤掉之后定时器线程就不会再碰那个池了。程序退出时还没到点的协程不会再被恢复。
+	class TimerQueue
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		//Schedule返回的编号，Cancel时用
+		struct TimerId
+		{
+			Clock::time_point Deadline;
+			uint64_t Sequence; //同一时刻到期的按提交顺序
+
+			bool operator<(const TimerId& other) const
+			{
+				return Deadline != other.Deadline ? Deadline < other.Deadline : Sequence < other.Sequence;
+			}
+		};
+
+		static TimerQueue& Get()
+		{
+			static TimerQueue instance;
+			return instance;
+		}
+
+		TimerId Schedule(Clock::time_point deadline, ThreadPool& pool, std::coroutine_handle<> handle)
+		{
+			TimerId id;
+			bool earliest;
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				id = { deadline, m_Sequence++ };
+				m_Timers.emplace(id, Timer{ &pool, handle });
+				earliest = m_Timers.begin()->first.Sequence == id.Sequence;
+			}
+			//只有新的最早到期时间才需要叫醒定时线程重新算等多久
+			if (earliest)
+				m_Changed.notify_one();
+			return id;
+		}
+
+		//还没到点时撤掉并返回true，协程不会被恢复（由调用者决定怎么办）；已经到点、交给池了返回false
+		bool Cancel(const TimerId& id)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Timers.erase(id) > 0;
+		}
+
+	private:
+		struct Timer
+		{
+			ThreadPool* Pool;
+			std::coroutine_handle<> Handle;
+		};
+
+		TimerQueue()
+			: m_Thread([this](std::stop_token stopToken) { Run(stopToken); })
+		{
+		}
+
+		void Run(std::stop_token stopToken)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (!stopToken.stop_requested())
+			{
+				if (m_Timers.empty())
+				{
+					m_Changed.wait(lock, stopToken, [this]() { return !m_Timers.empty(); });
+					continue;
+				}
+
+				//被Cancel撤掉或者来了更早的定时器都要重新算
+				TimerId earliest = m_Timers.begin()->first;
+				if (Clock::now() < earliest.Deadline)
+				{
+					m_Changed.wait_until(lock, stopToken, earliest.Deadline, [this, earliest]()
+					{
+						return m_Timers.empty() || m_Timers.begin()->first.Sequence != earliest.Sequence;
+					});
+					continue;
+				}
+
+				Timer timer = m_Timers.begin()->second;
+				m_Timers.erase(m_Timers.begin());
+				lock.unlock();
+				timer.Pool->Post([handle = timer.Handle]() { handle.resume(); });
+				lock.lock();
+			}
+		}
+
+		std::mutex m_Mutex;
+		std::condition_variable_any m_Changed;
+		std::map<TimerId, Timer> m_Timers; //按到期时间排序，可以按编号删除
+		uint64_t m_Sequence = 0;
+		std::jthread m_Thread; //最后初始化、最先析构
+	};
+
+	namespace detail
+	{
+		//SleepFor的取消：stop_callback不能移动，awaiter又最好是平凡析构的，所以放在堆上，await_resume时删掉。
+		//定时器一放进TimerQueue，协程就可能在别的线程上被恢复；await_resume要先拿到Mutex，等await_suspend把这里填完
+		struct SleepCancellation
+		{
+			std::mutex Mutex;
+			std::optional<std::stop_callback<std::function<void()>>> Callback;
+		};
+	}
+
+	//代替std::this_thread::sleep_for：挂起协程而不是阻塞线程，到点后在pool上继续。
+	//stopToken被请求停止时提前醒来（同样在pool上继续），定时器马上从TimerQueue里撤掉，不再引用pool
+	template<typename Rep, typename Period>
+	auto SleepFor(ThreadPool& pool, std::chrono::duration<Rep, Period> duration, std::stop_token stopToken = {})
+	{
+		struct Awaiter
+		{
+			ThreadPool& Pool;
+			TimerQueue::Clock::time_point Deadline;
+			std::stop_token StopToken;
+			detail::SleepCancellation* Cancellation = nullptr;
+
+			bool await_ready() noexcept { return TimerQueue::Clock::now() >= Deadline || StopToken.stop_requested(); }
+
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				if (!StopToken.stop_possible())
+				{
+					TimerQueue::Get().Schedule(Deadline, Pool, handle);
+					return;
+				}
+
+				Cancellation = new detail::SleepCancellation();
+				std::lock_guard<std::mutex> lock(Cancellation->Mutex);
+				TimerQueue::TimerId id = TimerQueue::Get().Schedule(Deadline, Pool, handle);
+				ThreadPool* pool = &Pool;
+				//已经请求停止时回调会在构造时同步执行
+				Cancellation->Callback.emplace(StopToken, std::function<void()>([pool, id, handle]()
+				{
+					//撤掉了才由这里恢复；已经到点的话定时器线程会恢复它
+					if (TimerQueue::Get().Cancel(id))
+						pool->Post([handle]() { handle.resume(); });
+				}));
+			}
+
+			void await_resume() noexcept
+			{
+				if (Cancellation)
+				{
+					Cancellation->Mutex.lock();
+					Cancellation->Mutex.unlock();
+					//回调如果还在别的线程上跑，stop_callback的析构会等它跑完
+					delete Cancellation;
+				}
+			}
+		};
+		return Awaiter{ pool, TimerQueue::Clock::now() + std::chrono::duration_cast<TimerQueue::Clock::duration>(duration), std::move(stopToken) };
+	}
+
+	namespace detail
+	{
+		template<typename T>
+		struct WhenAllState
+		{
+			explicit WhenAllState(size_t count) : Results(count) {}
+
+			std::vector<std::optional<Stored<T>>> Results;
+			std::atomic<size_t> Remaining{ 0 };
+			std::coroutine_handle<> Continuation;
+			std::mutex ExceptionMutex;
+			std::exception_ptr Exception;
+		};
+
+		template<typename T>
+		DetachedTask RunWhenAllChild(Task<T>& task, WhenAllState<T>& state, size_t index)
+		{
+			try
+			{
+				if constexpr (std::is_void_v<T>)
+				{
+					co_await task;
+					state.Results[index].emplace();
+				}
+				else
+				{
+					state.Results[index].emplace(co_await task);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state.ExceptionMutex);
+				if (!state.Exception)
+					state.Exception = std::current_exception();
+			}
+
+			if (state.Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				state.Continuation.resume();
+		}
+
+		template<typename T>
+		struct WhenAllAwaiter
+		{
+			std::vector<Task<T>>& Tasks;
+			WhenAllState<T>& State;
+
+			bool await_ready() noexcept { return Tasks.empty(); }
+
+			//多算1：所有子任务都启动完之前谁也不能恢复等待者（子任务可能在启动时就同步跑完）
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				State.Continuation = handle;
+				State.Remaining.store(Tasks.size() + 1, std::memory_order_relaxed);
+				for (size_t i = 0; i < Tasks.size(); i++)
+					RunWhenAllChild(Tasks[i], State, i);
+				return State.Remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+			}
+
+			void await_resume() noexcept {}
+		};
+
+		template<typename T>
+		struct WhenAnyState
+		{
+			std::vector<Task<T>> Tasks; //子任务帧归这里管，输掉的任务跑完之前一直活着
+			std::atomic<bool> Decided{ false };
+			std::atomic<int> Gate{ 2 }; //胜者 + await_suspend，两个都到了才恢复等待者
+			std::coroutine_handle<> Continuation;
+			size_t Index = 0;
+			std::optional<Stored<T>> Value;
+			std::exception_ptr Exception;
+		};
+
+		template<typename T>
+		DetachedTask RunWhenAnyChild(std::shared_ptr<WhenAnyState<T>> state, size_t index)
+		{
+			std::optional<Stored<T>> value;
+			std::exception_ptr exception;
+			try
+			{
+				if constexpr (std::is_void_v<T>)
+				{
+					co_await state->Tasks[index];
+					value.emplace();
+				}
+				else
+				{
+					value.emplace(co_await state->Tasks[index]);
+				}
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+
+			if (state->Decided.exchange(true, std::memory_order_acq_rel))
+				co_return;
+
+			state->Index = index;
+			state->Value = std::move(value);
+			state->Exception = exception;
+			if (state->Gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				state->Continuation.resume();
+		}
+
+		//拿引用而不是拷贝一份shared_ptr：co_await表达式里的临时awaiter只有平凡析构才不受编译器差异影响
+		template<typename T>
+		struct WhenAnyAwaiter
+		{
+			std::shared_ptr<WhenAnyState<T>>& State;
+
+			bool await_ready() noexcept { return false; }
+
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				State->Continuation = handle;
+				for (size_t i = 0; i < State->Tasks.size(); i++)
+					RunWhenAnyChild(State, i);
+				return State->Gate.fetch_sub(1, std::memory_order_acq_rel) != 1;
+			}
+
+			void await_resume() noexcept {}
+		};
+
+		struct SyncWaitEvent
+		{
+			std::mutex Mutex;
+			std::condition_variable Condition;
+			bool Done = false;
+
+			void Set()
+			{
+				//在锁里notify：等待者醒来返回、销毁这个对象时，这边已经不会再碰它了
+				std::lock_guard<std::mutex> lock(Mutex);
+				Done = true;
+				Condition.notify_all();
+			}
+
+			void Wait()
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				Condition.wait(lock, [this]() { return Done; });
+			}
+		};
+
+		template<typename T>
+		DetachedTask RunSyncWait(Task<T>& task, std::optional<Stored<T>>& result, std::exception_ptr& exception, SyncWaitEvent& event)
+		{
+			try
+			{
+				if constexpr (std::is_void_v<T>)
+				{
+					co_await task;
+					result.emplace();
+				}
+				else
+				{
+					result.emplace(co_await task);
+				}
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+			event.Set();
+		}
+	}
+
+	//所有任务都完成后继续；结果按原顺序返回。有任务抛异常时，等全部结束后重新抛出第一个异常
+	template<typename T>
+	Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> WhenAll(std::vector<Task<T>> tasks)
+	{
+		detail::WhenAllState<T> state(tasks.size());
+		co_await detail::WhenAllAwaiter<T>{ tasks, state };
+
+		if (state.Exception)
+			std::rethrow_exception(state.Exception);
+
+		if constexpr (std::is_void_v<T>)
+		{
+			co_return;
+		}
+		else
+		{
+			std::vector<T> results;
+			results.reserve(state.Results.size());
+			for (auto& result : state.Results)
+				results.push_back(std::move(*result));
+			co_return results;
+		}
+	}
+
+	template<typename T>
+	struct WhenAnyResult
+	{
+		size_t Index;
+		T Value;
+	};
+
+	template<>
+	struct WhenAnyResult<void>
+	{
+		size_t Index;
+	};
+
+	//第一个完成的任务决定结果（它抛的异常也会原样抛出），其余任务继续跑完，结果丢弃
+	template<typename T>
+	Task<WhenAnyResult<T>> WhenAny(std::vector<Task<T>> tasks)
+	{
+		if (tasks.empty())
+			throw std::invalid_argument("WhenAny needs at least one task");
+
+		auto state = std::make_shared<detail::WhenAnyState<T>>();
+		state->Tasks = std::move(tasks);
+		co_await detail::WhenAnyAwaiter<T>{ state };
+
+		if (state->Exception)
+			std::rethrow_exception(state->Exception);
+
+		if constexpr (std::is_void_v<T>)
+			co_return WhenAnyResult<void>{ state->Index };
+		else
+			co_return WhenAnyResult<T>{ state->Index, std::move(*state->Value) };
+	}
+
+	//在普通函数（比如main）里阻塞等一个Task完成，拿到结果
+	template<typename T>
+	T SyncWait(Task<T> task)
+	{
+		std::optional<detail::Stored<T>> result;
+		std::exception_ptr exception;
+		detail::SyncWaitEvent event;
+
+		detail::RunSyncWait(task, result, exception, event);
+		event.Wait();
+
+		if (exception)
+			std::rethrow_exception(exception);
+		if constexpr (!std::is_void_v<T>)
+			return std::move(*result);
+	}
+}
@@ -0,0 +1,171 @@
+#include "QueueBenchmark.h"
+#include "BoundedQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+//对照组：一把锁 + 两个condition_variable的有界队列
+template<typename T>
+class LockedQueue
+{
+public:
+	explicit LockedQueue(size_t capacity) : m_Capacity(capacity) {}
+
+	void Push(T value)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_NotFull.wait(lock, [this]() { return m_Queue.size() < m_Capacity; });
+		m_Queue.push(std::move(value));
+		lock.unlock();
+		m_NotEmpty.notify_one();
+	}
+
+	T Pop()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_NotEmpty.wait(lock, [this]() { return !m_Queue.empty(); });
+		T value = std::move(m_Queue.front());
+		m_Queue.pop();
+		lock.unlock();
+		m_NotFull.notify_one();
+		return value;
+	}
+
+private:
+	size_t m_Capacity;
+	std::mutex m_Mutex;
+	std::condition_variable m_NotFull;
+	std::condition_variable m_NotEmpty;
+	std::queue<T> m_Queue;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+//元素就是Push时的时间戳，Pop的时候一减就是这个元素在队列里待了多久
+template<typename Queue>
+static QueueBenchmarkResult Measure(Queue& queue, QueueKind kind, unsigned int producers, unsigned int consumers, const QueueBenchmarkOptions& options)
+{
+	uint64_t perProducer = options.Items / producers;
+	uint64_t items = perProducer * producers;
+
+	std::vector<std::vector<int64_t>> latencies(consumers);
+	for (unsigned int c = 0; c < consumers; c++)
+		latencies[c].reserve(items / consumers + 1);
+
+	auto start = Clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned int p = 0; p < producers; p++)
+	{
+		threads.emplace_back([&queue, perProducer]()
+		{
+			for (uint64_t i = 0; i < perProducer; i++)
+				queue.Push(Now());
+		});
+	}
+	for (unsigned int c = 0; c < consumers; c++)
+	{
+		//前面的消费者多分一个，保证加起来正好是items
+		uint64_t count = items / consumers + (c < items % consumers ? 1 : 0);
+		threads.emplace_back([&queue, &latency = latencies[c], count]()
+		{
+			for (uint64_t i = 0; i < count; i++)
+			{
+				int64_t pushed = queue.Pop();
+				latency.push_back(Now() - pushed);
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	std::vector<int64_t> all;
+	all.reserve(items);
+	for (auto& latency : latencies)
+		all.insert(all.end(), latency.begin(), latency.end());
+	std::sort(all.begin(), all.end());
+
+	QueueBenchmarkResult result;
+	result.Kind = kind;
+	result.Producers = producers;
+	result.Consumers = consumers;
+	result.Items = items;
+	result.Milliseconds = elapsed;
+	result.ItemsPerSecond = items / (elapsed * 1e-3);
+	result.LatencyP50Nanoseconds = all.empty() ? 0.0 : (double)all[all.size() / 2];
+	result.LatencyP99Nanoseconds = all.empty() ? 0.0 : (double)all[std::min(all.size() - 1, all.size() * 99 / 100)];
+	return result;
+}
+
+const char* ToString(QueueKind kind)
+{
+	switch (kind)
+	{
+	case QueueKind::Mutex: return "mutex+queue";
+	case QueueKind::Mpmc: return "MpmcQueue";
+	case QueueKind::Spsc: return "SpscQueue";
+	}
+	return "?";
+}
+
+QueueBenchmarkResult MeasureQueue(QueueKind kind, unsigned int producers, unsigned int consumers, const QueueBenchmarkOptions& options)
+{
+	switch (kind)
+	{
+	case QueueKind::Mutex:
+	{
+		LockedQueue<int64_t> queue(options.Capacity);
+		return Measure(queue, kind, producers, consumers, options);
+	}
+	case QueueKind::Mpmc:
+	{
+		MpmcQueue<int64_t> queue(options.Capacity);
+		return Measure(queue, kind, producers, consumers, options);
+	}
+	case QueueKind::Spsc:
+	default:
+	{
+		SpscQueue<int64_t> queue(options.Capacity);
+		return Measure(queue, kind, 1, 1, options);
+	}
+	}
+}
+
+std::vector<QueueBenchmarkResult> RunQueueBenchmark(const QueueBenchmarkOptions& options)
+{
+	std::cout << std::left << std::setw(14) << "queue" << std::right << std::setw(6) << "P" << std::setw(6) << "C"
+		<< std::setw(12) << "ms" << std::setw(14) << "Mitems/s" << std::setw(14) << "p50 us" << std::setw(14) << "p99 us" << std::endl;
+
+	std::vector<QueueBenchmarkResult> results;
+	for (const auto& [producers, consumers] : options.Shapes)
+	{
+		std::vector<QueueKind> kinds = { QueueKind::Mutex, QueueKind::Mpmc };
+		if (producers == 1 && consumers == 1)
+			kinds.push_back(QueueKind::Spsc);
+
+		for (QueueKind kind : kinds)
+		{
+			QueueBenchmarkResult result = MeasureQueue(kind, producers, consumers, options);
+			std::cout << std::left << std::setw(14) << ToString(kind) << std::right << std::setw(6) << producers << std::setw(6) << consumers
+				<< std::fixed << std::setprecision(2)
+				<< std::setw(12) << result.Milliseconds
+				<< std::setw(14) << result.ItemsPerSecond * 1e-6
+				<< std::setw(14) << result.LatencyP50Nanoseconds * 1e-3
+				<< std::setw(14) << result.LatencyP99Nanoseconds * 1e-3 << std::endl;
+			std::cout.unsetf(std::ios::floatfield);
+			results.push_back(result);
+		}
+	}
+	return results;
+}
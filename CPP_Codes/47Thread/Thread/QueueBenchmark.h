@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//MpmcQueue / SpscQueue 和 std::mutex + std::queue 比：不同生产者/消费者数量下的吞吐，以及一个元素从Push到被Pop出来的延迟。
+enum class QueueKind
+{
+	Mutex, Mpmc, Spsc
+};
+
+struct QueueBenchmarkOptions
+{
+	uint64_t Items = 1'000'000; //所有生产者加起来
+	size_t Capacity = 1024;
+	std::vector<std::pair<unsigned int, unsigned int>> Shapes = { { 1, 1 }, { 2, 2 }, { 4, 4 }, { 1, 4 }, { 4, 1 } }; //生产者, 消费者
+};
+
+struct QueueBenchmarkResult
+{
+	QueueKind Kind;
+	unsigned int Producers;
+	unsigned int Consumers;
+	uint64_t Items;
+	double Milliseconds;
+	double ItemsPerSecond;
+	double LatencyP50Nanoseconds;
+	double LatencyP99Nanoseconds;
+};
+
+const char* ToString(QueueKind kind);
+
+QueueBenchmarkResult MeasureQueue(QueueKind kind, unsigned int producers, unsigned int consumers, const QueueBenchmarkOptions& options);
+
+//SPSC只跑1x1
+std::vector<QueueBenchmarkResult> RunQueueBenchmark(const QueueBenchmarkOptions& options = {});
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "ThreadPool.h"
+
+//任务图（DAG）：每个节点记录还有几个前驱没完成（原子计数），一个节点跑完就把后继的计数减一，
+//减到0的后继马上Post到当前工作线程自己的deque里（不拿全局锁），其中最后一个直接在本线程接着跑。
+//
+//	TaskGraph graph(pool);
+//	auto load = graph.Add("Load", [] { ... });
+//	auto a = graph.Then(load, "A", [] { ... });
+//	auto b = graph.Then(load, "B", [] { ... });
+//	auto merge = graph.Add("Merge", [] { ... });
+//	graph.Precede(a, merge); graph.Precede(b, merge);
+//	graph.Run(); graph.WaitForAll();
+//
+//同一个图可以反复Run，每个节点会累计运行次数、运行时间和排队等待时间。
+//Run/WaitForAll/析构可以在这个池的任务里调用：等待的时候当前线程帮着跑池里的任务，不会把工作线程堵死。
+class TaskGraph
+{
+public:
+	using NodeId = size_t;
+
+	explicit TaskGraph(ThreadPool& pool)
+		: m_Pool(pool)
+	{
+	}
+
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	~TaskGraph()
+	{
+		WaitForAll();
+	}
+
+	NodeId Add(std::string name, std::function<void()> function)
+	{
+		auto node = std::make_unique<Node>();
+		node->Name = std::move(name);
+		node->Function = std::move(function);
+		m_Nodes.push_back(std::move(node));
+		return m_Nodes.size() - 1;
+	}
+
+	//before跑完之后after才能开始。加上这条边会成环时抛std::invalid_argument（有环的图永远跑不完，WaitForAll会一直等）
+	void Precede(NodeId before, NodeId after)
+	{
+		if (Reaches(m_Nodes[after].get(), m_Nodes[before].get()))
+			throw std::invalid_argument("TaskGraph::Precede: \"" + m_Nodes[before]->Name + "\" -> \"" + m_Nodes[after]->Name + "\" would create a cycle");
+		m_Nodes[before]->Successors.push_back(m_Nodes[after].get());
+		m_Nodes[after]->Predecessors++;
+	}
+
+	//续接：新建一个节点，等node完成后再跑
+	NodeId Then(NodeId node, std::string name, std::function<void()> function)
+	{
+		NodeId next = Add(std::move(name), std::move(function));
+		Precede(node, next);
+		return next;
+	}
+
+	//没有前驱的节点先开始；上一次Run没结束时先等它结束
+	void Run()
+	{
+		WaitForAll();
+
+		m_Exception = nullptr;
+		m_Finished = m_Nodes.empty();
+		m_Remaining.store((int64_t)m_Nodes.size());
+		for (auto& node : m_Nodes)
+			node->Pending.store(node->Predecessors, std::memory_order_relaxed);
+
+		auto now = Clock::now();
+		for (auto& node : m_Nodes)
+		{
+			if (node->Predecessors == 0)
+				Schedule(node.get(), now);
+		}
+	}
+
+	//第一个抛出的异常会在这里重新抛出（后继照常执行，图总会走完）
+	void WaitForAll()
+	{
+		if (m_Pool.CurrentWorkerIndex() >= 0)
+		{
+			while (m_Remaining.load(std::memory_order_acquire) != 0)
+			{
+				if (!m_Pool.TryRunOne())
+					std::this_thread::yield();
+			}
+		}
+
+		//计数到0之后最后一个节点的线程还要拿锁设置m_Finished，等它出了锁才能返回（返回之后图可能就被析构了）
+		std::unique_lock<std::mutex> lock(m_DoneMutex);
+		m_Done.wait(lock, [this]() { return m_Finished; });
+
+		if (m_Exception)
+		{
+			std::exception_ptr exception = m_Exception;
+			m_Exception = nullptr;
+			std::rethrow_exception(exception);
+		}
+	}
+
+	//按总运行时间排序
+	void PrintStats(std::ostream& stream = std::cout) const
+	{
+		std::vector<const Node*> nodes;
+		for (auto& node : m_Nodes)
+			nodes.push_back(node.get());
+		std::sort(nodes.begin(), nodes.end(), [](const Node* a, const Node* b) { return a->RunNanoseconds.load() > b->RunNanoseconds.load(); });
+
+		stream << std::left << std::setw(24) << "task" << std::right << std::setw(8) << "runs"
+			<< std::setw(14) << "total ms" << std::setw(12) << "avg us" << std::setw(12) << "max us" << std::setw(14) << "avg wait us" << std::endl;
+		stream << std::fixed << std::setprecision(3);
+		for (const Node* node : nodes)
+		{
+			uint64_t runs = node->Runs.load();
+			double total = (double)node->RunNanoseconds.load();
+			stream << std::left << std::setw(24) << node->Name << std::right << std::setw(8) << runs
+				<< std::setw(14) << total * 1e-6
+				<< std::setw(12) << (runs ? total * 1e-3 / runs : 0.0)
+				<< std::setw(12) << node->MaxRunNanoseconds.load() * 1e-3
+				<< std::setw(14) << (runs ? node->WaitNanoseconds.load() * 1e-3 / runs : 0.0) << std::endl;
+		}
+		stream.unsetf(std::ios::floatfield);
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Node
+	{
+		std::string Name;
+		std::function<void()> Function;
+		std::vector<Node*> Successors;
+		int64_t Predecessors = 0;
+		std::atomic<int64_t> Pending{ 0 };
+		Clock::time_point ReadyTime;
+
+		std::atomic<uint64_t> Runs{ 0 };
+		std::atomic<uint64_t> RunNanoseconds{ 0 };
+		std::atomic<uint64_t> MaxRunNanoseconds{ 0 };
+		std::atomic<uint64_t> WaitNanoseconds{ 0 }; //从可以跑到真正开始跑
+	};
+
+	static uint64_t Nanoseconds(Clock::duration duration)
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+	}
+
+	//从from沿着后继能不能走到to（from == to也算）
+	bool Reaches(const Node* from, const Node* to) const
+	{
+		std::vector<const Node*> stack = { from };
+		std::unordered_set<const Node*> visited;
+		while (!stack.empty())
+		{
+			const Node* node = stack.back();
+			stack.pop_back();
+			if (node == to)
+				return true;
+			if (!visited.insert(node).second)
+				continue;
+			for (const Node* successor : node->Successors)
+				stack.push_back(successor);
+		}
+		return false;
+	}
+
+	void Schedule(Node* node, Clock::time_point readyTime)
+	{
+		node->ReadyTime = readyTime;
+		m_Pool.Post([this, node]() { Execute(node); });
+	}
+
+	void Execute(Node* node)
+	{
+		while (node)
+		{
+			auto start = Clock::now();
+			try
+			{
+				node->Function();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(m_DoneMutex);
+				if (!m_Exception)
+					m_Exception = std::current_exception();
+			}
+			auto end = Clock::now();
+
+			uint64_t run = Nanoseconds(end - start);
+			node->Runs.fetch_add(1, std::memory_order_relaxed);
+			node->RunNanoseconds.fetch_add(run, std::memory_order_relaxed);
+			node->WaitNanoseconds.fetch_add(Nanoseconds(start - node->ReadyTime), std::memory_order_relaxed);
+			uint64_t max = node->MaxRunNanoseconds.load(std::memory_order_relaxed);
+			while (run > max && !node->MaxRunNanoseconds.compare_exchange_weak(max, run, std::memory_order_relaxed))
+			{
+			}
+
+			//减到0的后继：除了最后一个都Post出去给别的线程偷，最后一个自己接着跑（数据还在cache里）
+			Node* next = nullptr;
+			for (Node* successor : node->Successors)
+			{
+				if (successor->Pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+					continue;
+				if (next)
+					Schedule(next, end);
+				next = successor;
+				next->ReadyTime = end;
+			}
+
+			Finish();
+			node = next;
+		}
+	}
+
+	//平时只是一次原子减一，不拿锁。减到0的那个线程在锁里设置m_Finished并notify：
+	//WaitForAll等的是m_Finished而不是计数，它返回（图可能随即被析构）的时候这里已经不再碰图里的任何东西
+	void Finish()
+	{
+		if (m_Remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		std::lock_guard<std::mutex> lock(m_DoneMutex);
+		m_Finished = true;
+		m_Done.notify_all();
+	}
+
+	ThreadPool& m_Pool;
+	std::vector<std::unique_ptr<Node>> m_Nodes;
+
+	std::atomic<int64_t> m_Remaining{ 0 };
+	std::mutex m_DoneMutex;
+	std::condition_variable m_Done;
+	bool m_Finished = true; //m_DoneMutex保护
+	std::exception_ptr m_Exception;
+};
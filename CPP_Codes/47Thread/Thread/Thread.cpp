@@ -1,31 +1,244 @@
 ﻿#include <iostream>
+#include <atomic>
 #include <thread>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <stop_token>
+#include <string>
+#include <vector>
 
-static bool s_Finished = false;
+#include "ThreadPool.h"
+#include "TaskGraph.h"
+#include "Coroutine.h"
+#include "QueueBenchmark.h"
+#include "TimerWheel.h"
 
-void DoWork()
+#pragma region sleep polling
+//static bool s_Finished = false;
+//
+//void DoWork()
+//{
+//	using namespace std::literals::chrono_literals;
+//
+//	std::cout << std::this_thread::get_id() << std::endl;
+//
+//	while (!s_Finished)
+//	{
+//		std::cout << "working...\n";
+//		std::this_thread::sleep_for(1s);
+//	}
+//}
+//问题：s_Finished不是atomic，另一个线程写、这个线程读是数据竞争，编译器甚至可以把循环里的读提到循环外面。
+//而且worker每次都要睡满1秒才检查一次：停止要等最多1秒，有新活也要等最多1秒才开始干。
+#pragma endregion
+
+#pragma region stop_token + condition_variable_any
+static std::mutex s_Mutex;
+static std::condition_variable_any s_WorkAvailable;
+static int s_PendingWork = 0;
+
+void DoWork(std::stop_token stopToken)
 {
 	using namespace std::literals::chrono_literals;
 
 	std::cout << std::this_thread::get_id() << std::endl;
 
-	while (!s_Finished)
+	std::unique_lock<std::mutex> lock(s_Mutex);
+	while (!stopToken.stop_requested())
+	{
+		//有活、或者request_stop()时立刻醒来；都没有就一直睡，不占CPU。超时只是为了保留原来每秒一次的"working..."
+		if (s_WorkAvailable.wait_for(lock, stopToken, 1s, []() { return s_PendingWork > 0; }))
+		{
+			s_PendingWork--;
+			lock.unlock();
+			std::cout << "work item\n";
+			lock.lock();
+		}
+		else if (!stopToken.stop_requested())
+		{
+			std::cout << "working...\n";
+		}
+	}
+}
+
+void NotifyWork()
+{
 	{
-		std::cout << "working...\n";
-		std::this_thread::sleep_for(1s);
+		std::lock_guard<std::mutex> lock(s_Mutex);
+		s_PendingWork++;
 	}
+	s_WorkAvailable.notify_one();
+}
+#pragma endregion
+
+#pragma region coroutine
+//同样是"干一会儿、等一会儿"，协程版等待时把线程还给池，1万个逻辑任务只要1万个协程帧，不要1万个线程栈
+coro::Task<int> DoWorkAsync(ThreadPool& pool, int id)
+{
+	using namespace std::literals::chrono_literals;
+
+	co_await coro::ScheduleOn(pool);
+	co_await coro::SleepFor(pool, 50ms);//代替std::this_thread::sleep_for，不阻塞线程
+	co_return id % 7;
+}
+
+coro::Task<long long> Compute(ThreadPool& pool, int iterations)
+{
+	co_await coro::ScheduleOn(pool);
+	long long sum = 0;
+	for (int i = 0; i < iterations; i++)
+		sum += (long long)i * i % 7;
+	co_return sum;
+}
+
+coro::Task<long long> Timeout(ThreadPool& pool, std::chrono::milliseconds duration, std::stop_token stopToken)
+{
+	co_await coro::SleepFor(pool, duration, stopToken);
+	co_return -1;
+}
+
+coro::Task<> RunCoroutines(ThreadPool& pool)
+{
+	using namespace std::literals::chrono_literals;
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<coro::Task<int>> tasks;
+	for (int i = 0; i < 10000; i++)
+		tasks.push_back(DoWorkAsync(pool, i));
+	std::vector<int> results = co_await coro::WhenAll(std::move(tasks));
+
+	long long total = 0;
+	for (int result : results)
+		total += result;
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	std::cout << results.size() << " coroutines slept 50ms each on " << pool.Size() << " threads in " << elapsed.count() << "ms, sum " << total << std::endl;
+
+	//谁先完成用谁：计算 vs 超时
+	std::vector<coro::Task<long long>> race;
+	race.push_back(Compute(pool, 1000));
+	std::stop_source cancelTimeout;
+	race.push_back(Timeout(pool, 100ms, cancelTimeout.get_token()));
+	coro::WhenAnyResult<long long> winner = co_await coro::WhenAny(std::move(race));
+	//输掉的超时不能留在TimerQueue里：它记着pool的指针，pool没了之后到点就会Post到已经析构的池上
+	cancelTimeout.request_stop();
+	std::cout << "WhenAny: task " << winner.Index << " won with " << winner.Value << std::endl;
 }
+#pragma endregion
 
-int main()
+int main(int argc, char* argv[])
 {
-	std::thread worker(DoWork);
+	//Thread --queue：无锁有界队列 vs mutex+queue
+	if (argc > 1 && std::string(argv[1]) == "--queue")
+	{
+		RunQueueBenchmark();
+		return 0;
+	}
+
+	std::jthread worker(DoWork);//jthread自带stop_source，析构时会自动request_stop()并join()
+
+	std::cin.get();
+	NotifyWork();//马上被处理，不用等那1秒
 
 	std::cin.get();
-	s_Finished = true;
+	auto stopStart = std::chrono::steady_clock::now();
+	worker.request_stop();//condition_variable_any::wait_for收到stop请求会立刻返回
 
 	worker.join();//主线程执行到这句代码，就无法继续向下执行了，要等待worker线程执行完毕，才可以继续向下执行。在这句代码之前，主线程和worker是并行的。
+	auto stopTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - stopStart);
+	std::cout << "Stopped in " << stopTime.count() << "us" << std::endl;
 	std::cout << "Finished" << std::endl;
 	std::cout << std::this_thread::get_id() << std::endl;
 
+	//一个线程只能干一件事；ThreadPool把任务分给所有核，Submit返回future
+	{
+		ThreadPool pool;
+		std::cout << "ThreadPool with " << pool.Size() << " workers" << std::endl;
+
+		std::vector<std::future<long long>> results;
+		for (int chunk = 0; chunk < 16; chunk++)
+		{
+			results.push_back(pool.Submit([](int begin, int end)
+			{
+				long long sum = 0;
+				for (int i = begin; i < end; i++)
+					sum += (long long)i * i % 7;
+				return sum;
+			}, chunk * 1000000, (chunk + 1) * 1000000));
+		}
+
+		long long total = 0;
+		for (auto& result : results)
+			total += result.get();
+		std::cout << "Sum: " << total << std::endl;
+
+		//任务图：Load -> 8个Process并行（fan-out）-> Merge（fan-in）-> Report
+		std::vector<long long> partial(8);
+		long long merged = 0;
+
+		TaskGraph graph(pool);
+		TaskGraph::NodeId load = graph.Add("Load", []() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+		TaskGraph::NodeId merge = graph.Add("Merge", [&]()
+		{
+			merged = 0;
+			for (long long value : partial)
+				merged += value;
+		});
+		for (int i = 0; i < (int)partial.size(); i++)
+		{
+			TaskGraph::NodeId process = graph.Then(load, "Process " + std::to_string(i), [&partial, i]()
+			{
+				long long sum = 0;
+				for (int k = 0; k < 2000000; k++)
+					sum += (k ^ i) & 3;
+				partial[i] = sum;
+			});
+			graph.Precede(process, merge);
+		}
+		graph.Then(merge, "Report", [&]() { std::cout << "Merged: " << merged << std::endl; });
+
+		for (int run = 0; run < 3; run++)
+		{
+			graph.Run();
+			graph.WaitForAll();
+		}
+		graph.PrintStats();
+
+		coro::SyncWait(RunCoroutines(pool));
+
+		//"每秒干一次"不用sleep：时间轮里几万个超时，插入和取消都是O(1)，到期的回调在池里跑
+		{
+			using namespace std::literals::chrono_literals;
+
+			//计数器声明在时间轮前面：时间轮先析构，析构时等已经Post出去的回调跑完，回调里引用的计数器还在
+			std::atomic<int> fired = 0;
+			std::atomic<int> ticks = 0;
+			TimerWheel wheel(pool, 1ms);
+
+			std::vector<TimerWheel::TimerId> timeouts;
+			for (int i = 0; i < 20000; i++)
+				timeouts.push_back(wheel.Schedule(std::chrono::milliseconds(1 + i % 200), [&fired]() { fired++; }));
+			for (size_t i = 0; i < timeouts.size(); i += 2)
+				wheel.Cancel(timeouts[i]);//一半在到期前被取消，比如请求提前完成了
+
+			TimerWheel::TimerId periodic = wheel.SchedulePeriodic(50ms, [&ticks]() { ticks++; });
+			std::this_thread::sleep_for(300ms);
+			wheel.Cancel(periodic);
+
+			std::cout << "Timer wheel: " << fired << " of " << timeouts.size() << " timeouts fired, periodic ran " << ticks << " times" << std::endl;
+		}
+	}
+
+	//绑核：工作线程不再被OS迁来迁去，偷任务先在同一个NUMA节点里偷
+	{
+		CpuTopology topology = CpuTopology::Detect();
+		topology.Print();
+
+		ThreadPool pinned(std::thread::hardware_concurrency(), ThreadPool::Affinity::Compact);
+		for (unsigned int i = 0; i < pinned.Size(); i++)
+			std::cout << "worker " << i << " -> cpu " << pinned.WorkerCpu(i) << " (node " << pinned.WorkerNode(i) << ")" << std::endl;
+		std::cout << "task ran on cpu " << pinned.Submit(CurrentCpu).get() << std::endl;
+	}
+
 	std::cin.get();
 }
\ No newline at end of file
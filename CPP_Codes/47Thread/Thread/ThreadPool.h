@@ -0,0 +1,347 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Topology.h"
+#include "WorkStealingDeque.h"
+
+//固定数量的工作线程（默认=硬件线程数），每个线程一个Chase-Lev deque：
+//在工作线程里Submit的任务放进自己的deque，自己从bottom取（LIFO）；自己没活了就随机去别人的top偷（FIFO）。
+//外部线程Submit的任务进一个加锁的注入队列。没有任务时线程在condition_variable上睡觉，不占CPU。
+//析构时设置停止标志并唤醒所有线程，已经提交的任务会先跑完，future不会失效。
+//
+//Affinity不是None时每个工作线程绑到一个逻辑CPU上（Linux），线程自己分配自己的deque（first-touch，内存落在本地NUMA节点），
+//偷任务时先偷同一节点的线程，都偷不到才跨节点——跨socket搬cache line比同socket贵得多。
+class ThreadPool
+{
+public:
+	enum class Affinity
+	{
+		None,    //不绑核，OS随便调度
+		Compact, //先把一个节点的物理核占满（每个核先占一个超线程），再用下一个节点
+		Scatter  //各节点轮流放，内存带宽/LLC分摊到所有socket
+	};
+
+	explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency(), Affinity affinity = Affinity::None)
+		: m_Started(ClampThreadCount(threadCount))
+	{
+		threadCount = ClampThreadCount(threadCount);
+
+		CpuTopology topology = CpuTopology::Detect();
+		std::vector<CpuTopology::Cpu> placement = PlaceWorkers(topology, threadCount, affinity);
+
+		m_Workers.resize(threadCount);
+		m_NodeWorkers.resize(affinity == Affinity::None ? 1 : topology.NodeCount);
+		for (unsigned int i = 0; i < threadCount; i++)
+			m_NodeWorkers[affinity == Affinity::None ? 0 : placement[i].Node].push_back(i);
+
+		for (unsigned int i = 0; i < threadCount; i++)
+		{
+			int cpu = affinity == Affinity::None ? -1 : placement[i].Id;
+			int node = affinity == Affinity::None ? 0 : placement[i].Node;
+			m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i, cpu, node);
+		}
+		m_Started.wait();
+	}
+
+	~ThreadPool()
+	{
+		m_Stop.store(true);
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_SleepCondition.notify_all();
+
+		for (auto& thread : m_Threads)
+			thread.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template<typename Fn, typename... Args>
+	auto Submit(Fn&& fn, Args&&... args) -> std::future<std::invoke_result_t<std::decay_t<Fn>, std::decay_t<Args>...>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<Fn>, std::decay_t<Args>...>;
+
+		std::packaged_task<Result()> packaged(
+			[fn = std::forward<Fn>(fn), tuple = std::make_tuple(std::forward<Args>(args)...)]() mutable
+			{
+				return std::apply(std::move(fn), std::move(tuple));
+			});
+		std::future<Result> future = packaged.get_future();
+		Enqueue(new TaskImpl<std::packaged_task<Result()>>(std::move(packaged)));
+		return future;
+	}
+
+	//不需要返回值时少一次future的共享状态分配
+	template<typename Fn>
+	void Post(Fn&& fn)
+	{
+		Enqueue(new TaskImpl<std::decay_t<Fn>>(std::forward<Fn>(fn)));
+	}
+
+	unsigned int Size() const { return (unsigned int)m_Workers.size(); }
+
+	//工作线程绑定的逻辑CPU，没绑时返回-1
+	int WorkerCpu(unsigned int index) const { return m_Workers[index]->Cpu; }
+	int WorkerNode(unsigned int index) const { return m_Workers[index]->Node; }
+
+	//当前线程是这个池的工作线程时返回它的编号，否则返回-1
+	int CurrentWorkerIndex() const
+	{
+		return t_CurrentPool == this ? t_CurrentIndex : -1;
+	}
+
+	//工作线程在任务里等别的任务完成时用：取一个任务在当前线程跑掉，而不是把这个线程堵住
+	//（所有线程都在等的话就没人干活了，1个线程的池直接死锁）。不是工作线程或者没有任务时返回false
+	bool TryRunOne()
+	{
+		int index = CurrentWorkerIndex();
+		if (index < 0)
+			return false;
+		Task* task = FindTask((unsigned int)index);
+		if (!task)
+			return false;
+		m_Pending.fetch_sub(1);
+		task->Run();
+		delete task;
+		return true;
+	}
+
+private:
+	struct Task
+	{
+		virtual ~Task() = default;
+		virtual void Run() = 0;
+	};
+
+	template<typename Fn>
+	struct TaskImpl : Task
+	{
+		Fn Function;
+
+		explicit TaskImpl(Fn&& fn) : Function(std::move(fn)) {}
+		explicit TaskImpl(const Fn& fn) : Function(fn) {}
+
+		void Run() override { Function(); }
+	};
+
+	struct Worker
+	{
+		WorkStealingDeque<Task> Deque;
+		uint32_t RandomState = 0;
+		int Cpu = -1;
+		int Node = 0;
+	};
+
+	static unsigned int ClampThreadCount(unsigned int threadCount)
+	{
+		return threadCount == 0 ? 1 : threadCount;
+	}
+
+	//工作线程i绑到返回值[i]这个CPU上；线程比CPU多时循环使用
+	static std::vector<CpuTopology::Cpu> PlaceWorkers(const CpuTopology& topology, unsigned int threadCount, Affinity affinity)
+	{
+		//同一个物理核上的第几个超线程
+		std::vector<std::pair<int, CpuTopology::Cpu>> ranked;
+		for (const CpuTopology::Cpu& cpu : topology.Cpus)
+		{
+			int sibling = 0;
+			for (const CpuTopology::Cpu& other : topology.Cpus)
+			{
+				if (other.Package == cpu.Package && other.Core == cpu.Core && other.Id < cpu.Id)
+					sibling++;
+			}
+			ranked.push_back({ sibling, cpu });
+		}
+		std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b)
+		{
+			if (a.second.Node != b.second.Node)
+				return a.second.Node < b.second.Node;
+			if (a.first != b.first)
+				return a.first < b.first;
+			return a.second.Id < b.second.Id;
+		});
+
+		std::vector<CpuTopology::Cpu> order;
+		if (affinity == Affinity::Scatter)
+		{
+			std::vector<std::vector<CpuTopology::Cpu>> perNode(topology.NodeCount);
+			for (const auto& entry : ranked)
+				perNode[entry.second.Node].push_back(entry.second);
+			for (size_t round = 0; order.size() < ranked.size(); round++)
+			{
+				for (const auto& node : perNode)
+				{
+					if (round < node.size())
+						order.push_back(node[round]);
+				}
+			}
+		}
+		else
+		{
+			for (const auto& entry : ranked)
+				order.push_back(entry.second);
+		}
+
+		std::vector<CpuTopology::Cpu> placement;
+		for (unsigned int i = 0; i < threadCount; i++)
+			placement.push_back(order[i % order.size()]);
+		return placement;
+	}
+
+	void Enqueue(Task* task)
+	{
+		int index = CurrentWorkerIndex();
+		if (index >= 0)
+		{
+			m_Workers[index]->Deque.Push(task);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_InjectMutex);
+			m_Injected.push_back(task);
+		}
+
+		//和WorkerLoop里的检查配合：要么睡觉的线程看到m_Pending > 0，要么这里看到m_Sleeping > 0去唤醒
+		m_Pending.fetch_add(1);
+		if (m_Sleeping.load() > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_SleepMutex);
+			}
+			m_SleepCondition.notify_one();
+		}
+	}
+
+	Task* TakeInjected()
+	{
+		std::lock_guard<std::mutex> lock(m_InjectMutex);
+		if (m_Injected.empty())
+			return nullptr;
+		Task* task = m_Injected.front();
+		m_Injected.pop_front();
+		return task;
+	}
+
+	uint32_t NextRandom(Worker& worker)
+	{
+		//xorshift32
+		uint32_t x = worker.RandomState;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		worker.RandomState = x;
+		return x;
+	}
+
+	Task* FindTask(unsigned int index)
+	{
+		Worker& self = *m_Workers[index];
+		if (Task* task = self.Deque.Pop())
+			return task;
+		if (Task* task = TakeInjected())
+			return task;
+
+		//先偷同一个节点的，再按节点顺序偷别的节点的（没绑核时只有一个节点）
+		uint32_t random = NextRandom(self);
+		for (size_t n = 0; n < m_NodeWorkers.size(); n++)
+		{
+			const std::vector<unsigned int>& victims = m_NodeWorkers[(self.Node + n) % m_NodeWorkers.size()];
+			if (victims.empty())
+				continue;
+			size_t start = random % victims.size();
+			for (size_t i = 0; i < victims.size(); i++)
+			{
+				unsigned int victim = victims[(start + i) % victims.size()];
+				if (victim == index)
+					continue;
+				if (Task* task = m_Workers[victim]->Deque.Steal())
+					return task;
+			}
+		}
+		return nullptr;
+	}
+
+	void WorkerLoop(unsigned int index, int cpu, int node)
+	{
+		//先绑核再分配Worker：deque第一次被写的时候线程已经在目标节点上了
+		if (cpu >= 0 && !PinCurrentThread(cpu))
+			cpu = -1;
+		auto worker = std::make_unique<Worker>();
+		worker->RandomState = 0x9E3779B9u * (index + 1);
+		worker->Cpu = cpu;
+		worker->Node = node;
+		m_Workers[index] = std::move(worker);
+
+		//所有Worker都建好之后才能开始偷
+		m_Started.arrive_and_wait();
+
+		t_CurrentPool = this;
+		t_CurrentIndex = (int)index;
+
+		int idleSpins = 0;
+		while (true)
+		{
+			if (Task* task = FindTask(index))
+			{
+				m_Pending.fetch_sub(1);
+				task->Run();
+				delete task;
+				idleSpins = 0;
+				continue;
+			}
+
+			//还有任务没取到（比如刚好被别人抢走，或者Steal的CAS输了）就再找几轮
+			if (m_Pending.load() > 0 && ++idleSpins < 64)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			if (m_Stop.load() && m_Pending.load() == 0)
+				break;
+
+			m_Sleeping.fetch_add(1);
+			{
+				std::unique_lock<std::mutex> lock(m_SleepMutex);
+				m_SleepCondition.wait(lock, [this]() { return m_Pending.load() > 0 || m_Stop.load(); });
+			}
+			m_Sleeping.fetch_sub(1);
+			idleSpins = 0;
+		}
+
+		t_CurrentPool = nullptr;
+		t_CurrentIndex = -1;
+	}
+
+	std::vector<std::unique_ptr<Worker>> m_Workers;
+	std::vector<std::vector<unsigned int>> m_NodeWorkers; //每个NUMA节点上的工作线程编号
+	std::vector<std::thread> m_Threads;
+	std::latch m_Started;
+
+	std::mutex m_InjectMutex;
+	std::deque<Task*> m_Injected;
+
+	std::atomic<int64_t> m_Pending{ 0 };  //已提交还没开始跑的任务
+	std::atomic<int> m_Sleeping{ 0 };
+	std::atomic<bool> m_Stop{ false };
+	std::mutex m_SleepMutex;
+	std::condition_variable m_SleepCondition;
+
+	static inline thread_local const ThreadPool* t_CurrentPool = nullptr;
+	static inline thread_local int t_CurrentIndex = -1;
+};
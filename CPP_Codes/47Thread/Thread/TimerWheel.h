@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+//分层哈希时间轮（和Linux内核老版本的timer wheel同一个结构）：
+//第0层256个槽，每槽1个tick；第1~3层各64个槽，每槽分别是2^8、2^14、2^20个tick。
+//插入只是算出槽号挂到链表上，取消只是从链表上摘下来，都是O(1)，和有多少个定时器无关；
+//第0层转完一圈时把上一层当前槽里的定时器重新插一遍（cascade），它们会落到更低的层。
+//
+//一个ticker线程按tick推进时间轮，到期的回调Post到ThreadPool里执行，ticker自己不跑用户代码。
+//没有定时器时ticker在condition_variable_any上睡，不会空转。池必须比时间轮活得久。
+//析构时先停ticker，再等已经Post到池里的回调全部跑完，所以回调可以引用和时间轮一起销毁的东西（声明在时间轮前面即可）。
+//不要在池里的任务中析构时间轮：只有一个工作线程时，它等的回调就排在它自己后面。
+//回调抛出的异常不会传进池里（池里没人接，会直接terminate）：第一个异常留着，用TakeException()取。
+//
+//	TimerWheel wheel(pool, 1ms);
+//	TimerWheel::TimerId id = wheel.Schedule(500ms, [] { ... });
+//	wheel.SchedulePeriodic(1s, [] { std::cout << "working...\n"; });
+//	wheel.Cancel(id);
+class TimerWheel
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using TimerId = uint64_t; //高32位是代数，低32位是节点下标；节点复用后旧的id自动失效
+
+	static constexpr TimerId InvalidTimer = 0;
+
+	explicit TimerWheel(ThreadPool& pool, Clock::duration tick = std::chrono::milliseconds(1))
+		: m_Pool(pool), m_Tick(tick), m_Slots(SlotCount, NoNode), m_TickTime(Clock::now()),
+		m_Thread([this](std::stop_token stopToken) { Run(stopToken); })
+	{
+	}
+
+	~TimerWheel()
+	{
+		m_Thread.request_stop();
+		m_Thread.join();
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Drained.wait(lock, [this]() { return m_InFlight == 0; });
+	}
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	Clock::duration Tick() const { return m_Tick; }
+
+	TimerId Schedule(Clock::duration delay, std::function<void()> callback)
+	{
+		return Add(delay, 0, std::move(callback));
+	}
+
+	//第一次在period之后触发，之后每period触发一次，直到Cancel
+	TimerId SchedulePeriodic(Clock::duration period, std::function<void()> callback)
+	{
+		return Add(period, std::max<uint64_t>(1, ToTicks(period)), std::move(callback));
+	}
+
+	//已经触发（一次性的）或者已经取消的返回false。已经Post到池里的那次回调拦不住，析构时会等它跑完
+	bool Cancel(TimerId id)
+	{
+		uint32_t index = (uint32_t)id;
+		uint32_t generation = (uint32_t)(id >> 32);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (index >= m_Nodes.size() || m_Nodes[index].Generation != generation || m_Nodes[index].Slot == NoNode)
+			return false;
+		Unlink(index);
+		Release(index);
+		return true;
+	}
+
+	size_t ActiveCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Active;
+	}
+
+	//第一个抛出异常的回调的异常（之后的丢掉），取走后清空；没有时返回空
+	std::exception_ptr TakeException()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return std::exchange(m_Exception, nullptr);
+	}
+
+private:
+	static constexpr int RootBits = 8;
+	static constexpr int LevelBits = 6;
+	static constexpr int Levels = 4;
+	static constexpr uint32_t RootSize = 1u << RootBits;
+	static constexpr uint32_t LevelSize = 1u << LevelBits;
+	static constexpr uint32_t SlotCount = RootSize + (Levels - 1) * LevelSize;
+	static constexpr uint64_t MaxDelta = (1ull << (RootBits + (Levels - 1) * LevelBits)) - 1;
+	static constexpr uint32_t NoNode = UINT32_MAX;
+
+	//节点放在一个数组里用下标串成双向链表：取消时不用找，直接摘；释放的节点进空闲链表复用
+	struct Node
+	{
+		uint64_t Expiry = 0; //绝对tick
+		uint64_t Period = 0; //0表示一次性
+		uint32_t Generation = 1;
+		uint32_t Prev = NoNode;
+		uint32_t Next = NoNode;
+		uint32_t Slot = NoNode; //挂在哪个槽上，NoNode表示空闲
+		std::shared_ptr<std::function<void()>> Callback; //周期定时器每次触发共享同一个回调，不用每次拷贝
+	};
+
+	uint64_t ToTicks(Clock::duration duration) const
+	{
+		if (duration <= Clock::duration::zero())
+			return 0;
+		return (uint64_t)((duration + m_Tick - Clock::duration(1)) / m_Tick); //向上取整，不会提前触发
+	}
+
+	TimerId Add(Clock::duration delay, uint64_t period, std::function<void()> callback)
+	{
+		auto shared = std::make_shared<std::function<void()>>(std::move(callback));
+
+		bool wasIdle;
+		TimerId id;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			uint32_t index = Allocate();
+			Node& node = m_Nodes[index];
+			node.Expiry = m_CurrentTick + ToTicks(delay);
+			node.Period = period;
+			node.Callback = std::move(shared);
+			Insert(index);
+
+			wasIdle = m_Active++ == 0;
+			id = ((TimerId)node.Generation << 32) | index;
+		}
+		//ticker只在没有定时器时才睡在条件变量上，其余时候按tick醒
+		if (wasIdle)
+			m_Changed.notify_one();
+		return id;
+	}
+
+	uint32_t Allocate()
+	{
+		if (m_FreeList != NoNode)
+		{
+			uint32_t index = m_FreeList;
+			m_FreeList = m_Nodes[index].Next;
+			return index;
+		}
+		m_Nodes.emplace_back();
+		return (uint32_t)(m_Nodes.size() - 1);
+	}
+
+	void Release(uint32_t index)
+	{
+		Node& node = m_Nodes[index];
+		node.Callback.reset();
+		node.Generation++;
+		if (node.Generation == 0)
+			node.Generation = 1; //id永远不会是0（InvalidTimer）
+		node.Next = m_FreeList;
+		m_FreeList = index;
+		m_Active--;
+	}
+
+	void Insert(uint32_t index)
+	{
+		Node& node = m_Nodes[index];
+		uint64_t expiry = node.Expiry;
+		uint64_t delta = expiry - m_CurrentTick;
+		if (expiry < m_CurrentTick)
+		{
+			expiry = m_CurrentTick;
+			delta = 0;
+		}
+		else if (delta > MaxDelta)
+		{
+			//超出最高层的范围：先放在最远的位置，cascade下来时会按真实的Expiry重新插
+			expiry = m_CurrentTick + MaxDelta;
+			delta = MaxDelta;
+		}
+
+		uint32_t slot;
+		if (delta < RootSize)
+		{
+			slot = (uint32_t)(expiry & (RootSize - 1));
+		}
+		else
+		{
+			int level = 1;
+			while (delta >= (1ull << (RootBits + level * LevelBits)))
+				level++;
+			uint32_t offset = (uint32_t)((expiry >> (RootBits + (level - 1) * LevelBits)) & (LevelSize - 1));
+			slot = RootSize + (level - 1) * LevelSize + offset;
+		}
+
+		node.Slot = slot;
+		node.Prev = NoNode;
+		node.Next = m_Slots[slot];
+		if (node.Next != NoNode)
+			m_Nodes[node.Next].Prev = index;
+		m_Slots[slot] = index;
+	}
+
+	void Unlink(uint32_t index)
+	{
+		Node& node = m_Nodes[index];
+		if (node.Prev != NoNode)
+			m_Nodes[node.Prev].Next = node.Next;
+		else
+			m_Slots[node.Slot] = node.Next;
+		if (node.Next != NoNode)
+			m_Nodes[node.Next].Prev = node.Prev;
+		node.Slot = NoNode;
+		node.Prev = NoNode;
+		node.Next = NoNode;
+	}
+
+	//把上层一个槽里的定时器全部按当前时间重新插入，返回槽号（为0时说明这一层也转完了一圈，要继续往上cascade）
+	uint32_t Cascade(int level)
+	{
+		uint32_t offset = (uint32_t)((m_CurrentTick >> (RootBits + (level - 1) * LevelBits)) & (LevelSize - 1));
+		uint32_t slot = RootSize + (level - 1) * LevelSize + offset;
+
+		uint32_t index = m_Slots[slot];
+		m_Slots[slot] = NoNode;
+		while (index != NoNode)
+		{
+			uint32_t next = m_Nodes[index].Next;
+			Insert(index);
+			index = next;
+		}
+		return offset;
+	}
+
+	//推进一个tick，把到期的回调放进expired
+	void Advance(std::vector<std::shared_ptr<std::function<void()>>>& expired)
+	{
+		uint32_t rootIndex = (uint32_t)(m_CurrentTick & (RootSize - 1));
+		if (rootIndex == 0)
+		{
+			for (int level = 1; level < Levels && Cascade(level) == 0; level++)
+			{
+			}
+		}
+
+		uint32_t index = m_Slots[rootIndex];
+		m_Slots[rootIndex] = NoNode;
+		while (index != NoNode)
+		{
+			Node& node = m_Nodes[index];
+			uint32_t next = node.Next;
+			node.Slot = NoNode;
+
+			if (node.Expiry > m_CurrentTick)
+			{
+				//被MaxDelta截断过的，还没真正到期
+				Insert(index);
+			}
+			else
+			{
+				expired.push_back(node.Callback);
+				if (node.Period)
+				{
+					node.Expiry = m_CurrentTick + node.Period;
+					Insert(index);
+				}
+				else
+				{
+					Release(index);
+				}
+			}
+			index = next;
+		}
+
+		m_CurrentTick++;
+		m_TickTime += m_Tick;
+	}
+
+	void Run(std::stop_token stopToken)
+	{
+		std::vector<std::shared_ptr<std::function<void()>>> expired;
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (!stopToken.stop_requested())
+		{
+			if (m_Active == 0)
+			{
+				m_Changed.wait(lock, stopToken, [this]() { return m_Active > 0; });
+				//闲着的时候时间轮不转：从现在重新开始计时，不用补走空闲期间的几百万个tick
+				m_TickTime = Clock::now();
+				continue;
+			}
+
+			Clock::time_point next = m_TickTime + m_Tick;
+			if (Clock::now() < next)
+			{
+				m_Changed.wait_until(lock, stopToken, next, []() { return false; });
+				continue;
+			}
+
+			//落后了（比如线程被抢占）就把错过的tick一次补完
+			Clock::time_point now = Clock::now();
+			while (m_TickTime + m_Tick <= now)
+				Advance(expired);
+
+			m_InFlight += expired.size();
+			lock.unlock();
+			for (auto& callback : expired)
+			{
+				m_Pool.Post([this, callback = std::move(callback)]()
+				{
+					std::exception_ptr exception;
+					try
+					{
+						(*callback)();
+					}
+					catch (...)
+					{
+						exception = std::current_exception();
+					}
+					CallbackDone(std::move(exception));
+				});
+			}
+			expired.clear();
+			lock.lock();
+		}
+	}
+
+	//在锁里notify：析构函数看到0就会返回，之后这里不能再碰时间轮
+	void CallbackDone(std::exception_ptr exception)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (exception && !m_Exception)
+			m_Exception = std::move(exception);
+		if (--m_InFlight == 0)
+			m_Drained.notify_all();
+	}
+
+	ThreadPool& m_Pool;
+	const Clock::duration m_Tick;
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable_any m_Changed;
+	std::condition_variable m_Drained;
+	size_t m_InFlight = 0; //已经Post到池里、还没跑完的回调
+	std::exception_ptr m_Exception;
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_Slots; //每个槽链表的头节点
+	uint32_t m_FreeList = NoNode;
+	size_t m_Active = 0;
+	uint64_t m_CurrentTick = 0;   //下一个要处理的tick
+	Clock::time_point m_TickTime; //m_CurrentTick开始的时刻
+
+	std::jthread m_Thread; //最后初始化、最先析构（析构时request_stop并join）
+};
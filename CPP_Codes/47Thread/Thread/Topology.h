@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//CPU拓扑：每个逻辑CPU属于哪个NUMA节点、哪个物理封装（socket）、哪个物理核。
+//Linux上从/sys/devices/system/{cpu,node}读；其他平台（或者读不到）就当成一个节点、每个逻辑CPU一个核。
+//只列出这个进程能用的CPU：在cpuset/容器里（或者被taskset限制时）不在亲和性掩码里的CPU绑不上去，不能拿来放工作线程。
+struct CpuTopology
+{
+	struct Cpu
+	{
+		int Id = 0;
+		int Node = 0;
+		int Package = 0;
+		int Core = 0;
+	};
+
+	std::vector<Cpu> Cpus;
+	int NodeCount = 1;
+
+	static CpuTopology Detect()
+	{
+		CpuTopology topology;
+
+#if defined(__linux__)
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		bool hasMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+		for (int id : ParseCpuList(ReadFirstLine("/sys/devices/system/cpu/online")))
+		{
+			if (hasMask && id < CPU_SETSIZE && !CPU_ISSET(id, &allowed))
+				continue;
+
+			Cpu cpu;
+			cpu.Id = id;
+			std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+			cpu.Package = ReadInt(base + "physical_package_id", 0);
+			cpu.Core = ReadInt(base + "core_id", id);
+			topology.Cpus.push_back(cpu);
+		}
+
+		//没有node目录（没开NUMA的内核）时所有CPU都留在节点0
+		int maxNode = 0;
+		for (int node : ParseCpuList(ReadFirstLine("/sys/devices/system/node/online")))
+		{
+			for (int id : ParseCpuList(ReadFirstLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist")))
+			{
+				for (Cpu& cpu : topology.Cpus)
+				{
+					if (cpu.Id == id)
+						cpu.Node = node;
+				}
+			}
+			maxNode = std::max(maxNode, node);
+		}
+		topology.NodeCount = maxNode + 1;
+#endif
+
+		if (topology.Cpus.empty())
+		{
+			unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+			for (unsigned int i = 0; i < count; i++)
+			{
+				Cpu cpu;
+				cpu.Id = (int)i;
+				cpu.Core = (int)i;
+				topology.Cpus.push_back(cpu);
+			}
+			topology.NodeCount = 1;
+		}
+		return topology;
+	}
+
+	//"0-3,8,10-11" -> {0,1,2,3,8,10,11}
+	static std::vector<int> ParseCpuList(const std::string& list)
+	{
+		std::vector<int> result;
+		std::stringstream stream(list);
+		std::string range;
+		while (std::getline(stream, range, ','))
+		{
+			if (range.empty() || range.find_first_not_of(" \n") == std::string::npos)
+				continue;
+			size_t dash = range.find('-');
+			int first = std::stoi(range.substr(0, dash));
+			int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+			for (int i = first; i <= last; i++)
+				result.push_back(i);
+		}
+		return result;
+	}
+
+	void Print(std::ostream& stream = std::cout) const
+	{
+		stream << Cpus.size() << " CPUs on " << NodeCount << " NUMA node(s)" << std::endl;
+		for (const Cpu& cpu : Cpus)
+			stream << "  cpu" << cpu.Id << ": node " << cpu.Node << ", package " << cpu.Package << ", core " << cpu.Core << std::endl;
+	}
+
+private:
+	static std::string ReadFirstLine(const std::string& path)
+	{
+		std::ifstream file(path);
+		std::string line;
+		std::getline(file, line);
+		return line;
+	}
+
+	static int ReadInt(const std::string& path, int fallback)
+	{
+		std::string line = ReadFirstLine(path);
+		return line.empty() ? fallback : std::stoi(line);
+	}
+};
+
+//把当前线程绑到一个逻辑CPU上，之后OS不会再把它迁走。不支持的平台返回false
+inline bool PinCurrentThread(int cpu)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+//当前线程正在哪个逻辑CPU上跑，不知道时返回-1
+inline int CurrentCpu()
+{
+#if defined(__linux__)
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//Chase-Lev work-stealing deque（Lê, Pop, Cohen, Zappa Nardelli 2013的C11版本）。
+//只有owner线程可以Push/Pop（在bottom端，LIFO，缓存友好）；其他线程Steal（在top端，FIFO）。
+//存的是指针，满了就把数组扩大一倍；旧数组可能还有小偷在读，所以留到析构时再释放。
+template<typename T>
+class WorkStealingDeque
+{
+public:
+	explicit WorkStealingDeque(int64_t capacity = 256)
+	{
+		m_Arrays.push_back(std::make_unique<Array>(capacity));
+		m_Array.store(m_Arrays.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	//owner
+	void Push(T* item)
+	{
+		int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		int64_t top = m_Top.load(std::memory_order_acquire);
+		Array* array = m_Array.load(std::memory_order_relaxed);
+		if (bottom - top > array->Capacity - 1)
+			array = Grow(array, top, bottom);
+
+		array->Put(bottom, item);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	//owner，空的时候返回nullptr
+	T* Pop()
+	{
+		int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		Array* array = m_Array.load(std::memory_order_relaxed);
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_Top.load(std::memory_order_relaxed);
+
+		T* item = nullptr;
+		if (top <= bottom)
+		{
+			item = array->Get(bottom);
+			if (top == bottom)
+			{
+				//只剩最后一个，和小偷抢
+				if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					item = nullptr;
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+		}
+		else
+		{
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return item;
+	}
+
+	//任意线程，空的或者抢输了返回nullptr
+	T* Steal()
+	{
+		int64_t top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return nullptr;
+
+		Array* array = m_Array.load(std::memory_order_acquire);
+		T* item = array->Get(top);
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return item;
+	}
+
+	bool Empty() const
+	{
+		int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		int64_t top = m_Top.load(std::memory_order_relaxed);
+		return bottom <= top;
+	}
+
+private:
+	struct Array
+	{
+		int64_t Capacity;
+		int64_t Mask;
+		std::unique_ptr<std::atomic<T*>[]> Items;
+
+		explicit Array(int64_t capacity)
+			: Capacity(capacity), Mask(capacity - 1), Items(new std::atomic<T*>[capacity])
+		{
+		}
+
+		T* Get(int64_t index) const { return Items[index & Mask].load(std::memory_order_relaxed); }
+		void Put(int64_t index, T* item) { Items[index & Mask].store(item, std::memory_order_relaxed); }
+	};
+
+	Array* Grow(Array* array, int64_t top, int64_t bottom)
+	{
+		auto bigger = std::make_unique<Array>(array->Capacity * 2);
+		for (int64_t i = top; i < bottom; i++)
+			bigger->Put(i, array->Get(i));
+
+		Array* result = bigger.get();
+		m_Arrays.push_back(std::move(bigger)); //只有owner会改m_Arrays
+		m_Array.store(result, std::memory_order_release);
+		return result;
+	}
+
+	//top和bottom分别被小偷和owner频繁写，放在不同的cache line上
+	alignas(64) std::atomic<int64_t> m_Top{ 0 };
+	alignas(64) std::atomic<int64_t> m_Bottom{ 0 };
+	alignas(64) std::atomic<Array*> m_Array{ nullptr };
+	std::vector<std::unique_ptr<Array>> m_Arrays;
+};
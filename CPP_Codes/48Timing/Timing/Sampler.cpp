@@ -0,0 +1,361 @@
+#include "Sampler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__) && defined(__x86_64__)
+#define SAMPLER_SUPPORTED 1
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#else
+#define SAMPLER_SUPPORTED 0
+#endif
+
+struct Sampler::ThreadState
+{
+	static constexpr uint64_t Capacity = 512; //2的幂；1kHz下后台线程100ms取一次，够用
+
+	struct Sample
+	{
+		uint32_t Depth;
+		uintptr_t Frames[MaxDepth]; //叶子在前
+	};
+
+	Sample Samples[Capacity];
+	std::atomic<uint64_t> Head{ 0 }; //只有信号处理函数写
+	std::atomic<uint64_t> Tail{ 0 }; //只有Collect写
+	std::atomic<uint64_t> Dropped{ 0 };
+
+	uintptr_t StackLow = 0;
+	uintptr_t StackHigh = 0;
+	bool Registered = false;
+#if SAMPLER_SUPPORTED
+	timer_t Timer{};
+	bool HasTimer = false;
+#endif
+};
+
+#if SAMPLER_SUPPORTED
+//信号处理函数只能碰本线程的这个指针和环形缓冲区，不能加锁、不能分配内存
+static thread_local Sampler::ThreadState* t_SamplerState = nullptr;
+
+static void OnSampleSignal(int, siginfo_t*, void* context)
+{
+	Sampler::ThreadState* state = t_SamplerState;
+	if (!state)
+		return;
+
+	int savedErrno = errno;
+
+	uint64_t head = state->Head.load(std::memory_order_relaxed);
+	uint64_t tail = state->Tail.load(std::memory_order_acquire);
+	if (head - tail >= Sampler::ThreadState::Capacity)
+	{
+		state->Dropped.store(state->Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		errno = savedErrno;
+		return;
+	}
+
+	Sampler::ThreadState::Sample& sample = state->Samples[head & (Sampler::ThreadState::Capacity - 1)];
+	const ucontext_t* ucontext = (const ucontext_t*)context;
+	uintptr_t pc = (uintptr_t)ucontext->uc_mcontext.gregs[REG_RIP];
+	uintptr_t fp = (uintptr_t)ucontext->uc_mcontext.gregs[REG_RBP];
+
+	uint32_t depth = 0;
+	sample.Frames[depth++] = pc;
+
+	//frame pointer链：[rbp]是上一层的rbp，[rbp + 8]是返回地址。每一步都检查还在本线程栈内并且往高地址走
+	while (depth < (uint32_t)Sampler::MaxDepth && fp >= state->StackLow && fp + 2 * sizeof(uintptr_t) <= state->StackHigh && (fp & 7) == 0)
+	{
+		const uintptr_t* frame = (const uintptr_t*)fp;
+		uintptr_t next = frame[0];
+		uintptr_t ret = frame[1];
+		if (ret == 0)
+			break;
+		sample.Frames[depth++] = ret - 1; //返回地址的前一个字节才在call指令所在的函数里
+		if (next <= fp)
+			break;
+		fp = next;
+	}
+	sample.Depth = depth;
+
+	state->Head.store(head + 1, std::memory_order_release);
+	errno = savedErrno;
+}
+
+static void InstallSignalHandler()
+{
+	static bool s_Installed = false;
+	if (s_Installed)
+		return;
+
+	struct sigaction action = {};
+	action.sa_sigaction = OnSampleSignal;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGPROF, &action, nullptr);
+	s_Installed = true;
+}
+
+static void ArmTimer(Sampler::ThreadState& state, int frequencyHz)
+{
+	if (!state.HasTimer)
+		return;
+
+	long interval = frequencyHz > 0 ? 1000000000L / frequencyHz : 0;
+	itimerspec spec = {};
+	spec.it_interval.tv_sec = interval / 1000000000L;
+	spec.it_interval.tv_nsec = interval % 1000000000L;
+	spec.it_value = spec.it_interval;
+	timer_settime(state.Timer, 0, &spec, nullptr);
+}
+#endif
+
+Sampler& Sampler::Get()
+{
+	static Sampler instance;
+	return instance;
+}
+
+bool Sampler::IsSupported()
+{
+	return SAMPLER_SUPPORTED != 0;
+}
+
+void Sampler::RegisterThread()
+{
+#if SAMPLER_SUPPORTED
+	if (t_SamplerState)
+		return;
+
+	auto state = std::make_shared<ThreadState>();
+
+	pthread_attr_t attr;
+	if (pthread_getattr_np(pthread_self(), &attr) == 0)
+	{
+		void* stack = nullptr;
+		size_t size = 0;
+		pthread_attr_getstack(&attr, &stack, &size);
+		state->StackLow = (uintptr_t)stack;
+		state->StackHigh = (uintptr_t)stack + size;
+		pthread_attr_destroy(&attr);
+	}
+
+	//CLOCK_THREAD_CPUTIME_ID：按本线程消耗的CPU时间计时，SIGEV_THREAD_ID：信号只发给本线程
+	sigevent event = {};
+	event.sigev_notify = SIGEV_THREAD_ID;
+	event.sigev_signo = SIGPROF;
+	event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+	state->HasTimer = timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &state->Timer) == 0;
+	state->Registered = true;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Threads.push_back(state);
+	t_SamplerState = state.get();
+	if (m_Running)
+		ArmTimer(*state, m_FrequencyHz);
+#endif
+}
+
+void Sampler::UnregisterThread()
+{
+#if SAMPLER_SUPPORTED
+	ThreadState* state = t_SamplerState;
+	if (!state)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (state->HasTimer)
+	{
+		timer_delete(state->Timer);
+		state->HasTimer = false;
+	}
+	t_SamplerState = nullptr;
+	state->Registered = false; //缓冲区里剩下的样本下次Collect时取走
+#endif
+}
+
+void Sampler::Start(int frequencyHz)
+{
+#if SAMPLER_SUPPORTED
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Running)
+			return;
+
+		InstallSignalHandler();
+		m_FrequencyHz = frequencyHz;
+		m_Running = true;
+		for (auto& state : m_Threads)
+			ArmTimer(*state, m_FrequencyHz);
+	}
+
+	m_StopCollector = false;
+	m_Collector = std::thread([this]()
+	{
+		std::unique_lock<std::mutex> lock(m_CollectorMutex);
+		while (!m_StopCollector)
+		{
+			lock.unlock();
+			Collect();
+			lock.lock();
+
+			m_CollectorWakeup.wait_for(lock, std::chrono::milliseconds(100), [this]() { return m_StopCollector; });
+		}
+	});
+#else
+	(void)frequencyHz;
+#endif
+}
+
+void Sampler::Stop()
+{
+#if SAMPLER_SUPPORTED
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_Running)
+			return;
+
+		for (auto& state : m_Threads)
+			ArmTimer(*state, 0);
+		m_Running = false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_CollectorMutex);
+		m_StopCollector = true;
+	}
+	m_CollectorWakeup.notify_one();
+	m_Collector.join();
+	Collect();
+#endif
+}
+
+void Sampler::Collect()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<uintptr_t> stack;
+	for (auto& state : m_Threads)
+	{
+		uint64_t tail = state->Tail.load(std::memory_order_relaxed);
+		uint64_t head = state->Head.load(std::memory_order_acquire);
+		for (; tail != head; tail++)
+		{
+			const ThreadState::Sample& sample = state->Samples[tail & (ThreadState::Capacity - 1)];
+			stack.assign(sample.Frames, sample.Frames + sample.Depth);
+			std::reverse(stack.begin(), stack.end());
+			m_Stacks[stack]++;
+			m_Samples++;
+		}
+		state->Tail.store(tail, std::memory_order_release);
+	}
+
+	//已经注销并且取空了的线程不用再留着
+	m_Threads.erase(std::remove_if(m_Threads.begin(), m_Threads.end(), [this](const std::shared_ptr<ThreadState>& state)
+	{
+		if (state->Registered || state->Tail.load() != state->Head.load())
+			return false;
+		m_Dropped += state->Dropped.load(std::memory_order_relaxed);
+		return true;
+	}), m_Threads.end());
+}
+
+std::string Sampler::Symbolize(uintptr_t address)
+{
+	auto it = m_Symbols.find(address);
+	if (it != m_Symbols.end())
+		return it->second;
+
+	std::string name;
+#if SAMPLER_SUPPORTED
+	Dl_info info = {};
+	if (dladdr((void*)address, &info) && info.dli_sname)
+	{
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+		name = status == 0 && demangled ? demangled : info.dli_sname;
+		free(demangled);
+	}
+	else if (info.dli_fname)
+	{
+		//没有符号（没加-rdynamic的static函数等）：输出 模块+偏移，之后可以用addr2line还原
+		std::stringstream stream;
+		const char* module = strrchr(info.dli_fname, '/');
+		stream << (module ? module + 1 : info.dli_fname) << "+0x" << std::hex << (address - (uintptr_t)info.dli_fbase);
+		name = stream.str();
+	}
+#endif
+	if (name.empty())
+	{
+		std::stringstream stream;
+		stream << "0x" << std::hex << address;
+		name = stream.str();
+	}
+	m_Symbols[address] = name;
+	return name;
+}
+
+void Sampler::WriteFolded(std::ostream& stream)
+{
+	Collect();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	//同一个函数里不同的pc合并成一行
+	std::map<std::string, uint64_t> folded;
+	for (auto& [stack, count] : m_Stacks)
+	{
+		std::string line;
+		for (uintptr_t address : stack)
+		{
+			if (!line.empty())
+				line += ';';
+			line += Symbolize(address);
+		}
+		folded[line] += count;
+	}
+
+	for (auto& [line, count] : folded)
+		stream << line << " " << count << "\n";
+}
+
+bool Sampler::WriteFolded(const std::string& filepath)
+{
+	std::ofstream stream(filepath);
+	if (!stream)
+		return false;
+	WriteFolded(stream);
+	return (bool)stream;
+}
+
+uint64_t Sampler::SampleCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Samples;
+}
+
+uint64_t Sampler::DroppedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	uint64_t dropped = m_Dropped;
+	for (auto& state : m_Threads)
+		dropped += state->Dropped.load(std::memory_order_relaxed);
+	return dropped;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//采样profiler：PROFILE_SCOPE/TIME_SCOPE只能看到手动包起来的代码，Sampler每隔一段CPU时间打断线程一次，
+//记下当时的调用栈，最后输出folded stacks（"main;HandleRequest;Parse 123"），可以直接喂给flamegraph.pl。
+//
+//每个线程用timer_create(CLOCK_THREAD_CPUTIME_ID)建一个只发给自己的SIGPROF，线程不跑就不采样；
+//信号处理函数里用frame pointer回溯调用栈，写进本线程的无锁环形缓冲区，后台线程定期取走汇总。
+//
+//只支持Linux x86-64，并且要用-fno-omit-frame-pointer编译（链接加-rdynamic才能看到函数名）；
+//其他平台IsSupported()返回false，所有调用都是空操作。
+class Sampler
+{
+public:
+	static constexpr int MaxDepth = 64;
+
+	static Sampler& Get();
+	static bool IsSupported();
+
+	//要被采样的线程自己调用一次（Start之前或之后都可以）
+	void RegisterThread();
+	void UnregisterThread();
+
+	void Start(int frequencyHz = 1000);
+	void Stop();
+
+	//把环形缓冲区里的样本取出来汇总，Start之后后台线程会每100ms调一次
+	void Collect();
+
+	void WriteFolded(std::ostream& stream);
+	bool WriteFolded(const std::string& filepath);
+
+	uint64_t SampleCount() const;
+	uint64_t DroppedCount() const;
+
+	struct ThreadState;
+
+private:
+	Sampler() = default;
+
+	std::string Symbolize(uintptr_t address);
+
+	mutable std::mutex m_Mutex;
+	std::vector<std::shared_ptr<ThreadState>> m_Threads;
+	std::map<std::vector<uintptr_t>, uint64_t> m_Stacks; //根在前
+	std::map<uintptr_t, std::string> m_Symbols;
+	uint64_t m_Samples = 0;
+	int m_FrequencyHz = 0;
+	bool m_Running = false;
+
+	uint64_t m_Dropped = 0; //已经移除的线程丢掉的样本
+
+	std::thread m_Collector;
+	std::mutex m_CollectorMutex;
+	std::condition_variable m_CollectorWakeup;
+	bool m_StopCollector = false;
+};
+
+//RAII：线程进入时注册，退出作用域时注销
+class SamplerThreadScope
+{
+public:
+	SamplerThreadScope() { Sampler::Get().RegisterThread(); }
+	~SamplerThreadScope() { Sampler::Get().UnregisterThread(); }
+
+	SamplerThreadScope(const SamplerThreadScope&) = delete;
+	SamplerThreadScope& operator=(const SamplerThreadScope&) = delete;
+};
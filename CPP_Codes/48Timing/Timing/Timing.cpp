@@ -2,18 +2,22 @@
 #include <chrono>
 #include <thread>
 
+#include "Instrumentor.h"
+#include "TimingTree.h"
+#include "Sampler.h"
+
 struct Timer
 {
 	std::chrono::time_point<std::chrono::steady_clock> start, end;
 	std::chrono::duration<float> duration;
 	Timer()
 	{
-		start = std::chrono::high_resolution_clock::now();
+		start = std::chrono::steady_clock::now();
 	}
 
 	~Timer()
 	{
-		end = std::chrono::high_resolution_clock::now();
+		end = std::chrono::steady_clock::now();
 		duration = end - start;
 
 		float ms = duration.count() * 1000.0f;
@@ -28,6 +32,62 @@ void Function()
 		std::cout << "Hello" << std::endl;
 }
 
+//Timer只会打印一行数字；PROFILE_FUNCTION/PROFILE_SCOPE会把每一段的开始、结束和线程写进results.json，
+//用chrome://tracing打开就能看到每个线程的时间线。
+void Compute(int value)
+{
+	PROFILE_FUNCTION();
+
+	double sum = 0.0;
+	for (int i = 0; i < 1000000; i++)
+		sum += value * 0.5 + i;
+
+	volatile double result = sum;
+	(void)result;
+}
+
+void RunWorker()
+{
+	PROFILE_FUNCTION();
+
+	for (int i = 0; i < 10; i++)
+	{
+		PROFILE_SCOPE("Iteration");
+		Compute(i);
+	}
+}
+
+//同一个函数被调用很多次时，用TIME_FUNCTION建调用树，最后看汇总
+int Parse(int value)
+{
+	TIME_FUNCTION();
+
+	int result = 0;
+	for (int i = 0; i < 50; i++)
+		result += (value ^ i) & 7;
+	return result;
+}
+
+int Validate(int value)
+{
+	TIME_FUNCTION();
+
+	return Parse(value) + Parse(value + 1);
+}
+
+int HandleRequest(int id)
+{
+	TIME_FUNCTION();
+
+	int result = Validate(id);
+	{
+		TIME_SCOPE("Respond");
+		for (int i = 0; i < 100; i++)
+			result += Parse(id + i) & 1;
+	}
+	return result;
+}
+
 //Timing:计时系统
 int main()
 {
@@ -37,5 +97,40 @@ int main()
 
 	Function();
 
+	Instrumentor::Get().BeginSession("Timing", "results.json");
+	{
+		std::thread a(RunWorker);
+		std::thread b(RunWorker);
+		RunWorker();
+		a.join();
+		b.join();
+	}
+	Instrumentor::Get().EndSession();
+
+	{
+		long long sum = 0;
+		for (int id = 0; id < 10000; id++)
+			sum += HandleRequest(id);
+		std::cout << sum << std::endl;
+	}
+	TimingTree::Get().PrintTree();
+	TimingTree::Get().Report();
+
+	//采样：不需要在代码里加任何宏，输出profile.folded，用flamegraph.pl profile.folded > flame.svg 画火焰图
+	if (Sampler::IsSupported())
+	{
+		SamplerThreadScope samplerThread;
+		Sampler::Get().Start(1000);
+
+		long long sum = 0;
+		for (int id = 0; id < 50000; id++)
+			sum += HandleRequest(id);
+		std::cout << sum << std::endl;
+
+		Sampler::Get().Stop();
+		Sampler::Get().WriteFolded("profile.folded");
+		std::cout << Sampler::Get().SampleCount() << " samples (" << Sampler::Get().DroppedCount() << " dropped)" << std::endl;
+	}
+
 	std::cin.get();
 }
\ No newline at end of file
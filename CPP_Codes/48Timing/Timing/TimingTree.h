@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "TscClock.h"
+
+//层级计时：Timer每个作用域打印一行，同一个函数进出几百万次时根本没法看。
+//TIME_SCOPE/TIME_FUNCTION在每个线程里建一棵调用树，每个节点累加调用次数、inclusive时间（包含子调用）
+//和self时间（去掉子调用），需要时调用TimingTree::Get().Report()打印按self时间排序的汇总。
+//
+//只有本线程会写自己的树，计数用relaxed的load/store，不需要原子读改写；新建节点时才拿锁，
+//这样Report()可以在其他线程还在跑的时候安全地读。
+class TimingTree
+{
+public:
+	struct Node
+	{
+		const char* Name = "";
+		Node* Parent = nullptr;
+		std::atomic<uint64_t> Count{ 0 };
+		std::atomic<uint64_t> InclusiveNanoseconds{ 0 };
+		std::atomic<uint64_t> ChildNanoseconds{ 0 };
+		std::vector<std::unique_ptr<Node>> Children;
+
+		uint64_t SelfNanoseconds() const
+		{
+			uint64_t inclusive = InclusiveNanoseconds.load(std::memory_order_relaxed);
+			uint64_t children = ChildNanoseconds.load(std::memory_order_relaxed);
+			return inclusive > children ? inclusive - children : 0;
+		}
+	};
+
+	static TimingTree& Get()
+	{
+		static TimingTree instance;
+		return instance;
+	}
+
+	Node* Enter(const char* name)
+	{
+		ThreadTree& tree = GetThreadTree();
+		Node* parent = tree.Current;
+
+		for (auto& child : parent->Children)
+		{
+			if (child->Name == name || strcmp(child->Name, name) == 0)
+			{
+				tree.Current = child.get();
+				return tree.Current;
+			}
+		}
+
+		auto node = std::make_unique<Node>();
+		node->Name = name;
+		node->Parent = parent;
+		tree.Current = node.get();
+
+		std::lock_guard<std::mutex> lock(tree.Mutex);
+		parent->Children.push_back(std::move(node));
+		return tree.Current;
+	}
+
+	void Exit(Node* node, uint64_t nanoseconds)
+	{
+		Add(node->Count, 1);
+		Add(node->InclusiveNanoseconds, nanoseconds);
+		Add(node->Parent->ChildNanoseconds, nanoseconds);
+		GetThreadTree().Current = node->Parent;
+	}
+
+	//所有线程按名字合并，按self时间从大到小
+	void Report(std::ostream& stream = std::cout, size_t maxRows = 30)
+	{
+		struct Entry
+		{
+			uint64_t Count = 0;
+			uint64_t Inclusive = 0;
+			uint64_t Self = 0;
+		};
+		std::map<std::string, Entry> entries;
+		uint64_t total = 0;
+
+		for (auto& tree : GetTrees())
+		{
+			std::lock_guard<std::mutex> lock(tree->Mutex);
+			std::vector<const char*> stack;
+			for (auto& root : tree->Root.Children)
+			{
+				total += root->InclusiveNanoseconds.load(std::memory_order_relaxed);
+				Collect(*root, stack, [&](const Node& node, bool recursive)
+				{
+					Entry& entry = entries[node.Name];
+					entry.Count += node.Count.load(std::memory_order_relaxed);
+					entry.Self += node.SelfNanoseconds();
+					//递归调用时外层的inclusive已经包含了内层，不能再加一次
+					if (!recursive)
+						entry.Inclusive += node.InclusiveNanoseconds.load(std::memory_order_relaxed);
+				});
+			}
+		}
+
+		std::vector<std::pair<std::string, Entry>> sorted(entries.begin(), entries.end());
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.Self > b.second.Self; });
+
+		stream << std::left << std::setw(40) << "scope" << std::right << std::setw(12) << "count"
+			<< std::setw(14) << "self ms" << std::setw(8) << "self%" << std::setw(14) << "incl ms" << std::setw(12) << "avg us" << std::endl;
+		stream << std::fixed;
+		for (size_t i = 0; i < sorted.size() && i < maxRows; i++)
+		{
+			const Entry& entry = sorted[i].second;
+			stream << std::left << std::setw(40) << sorted[i].first.substr(0, 39) << std::right
+				<< std::setw(12) << entry.Count
+				<< std::setprecision(3) << std::setw(14) << entry.Self * 1e-6
+				<< std::setprecision(1) << std::setw(8) << (total ? 100.0 * entry.Self / total : 0.0)
+				<< std::setprecision(3) << std::setw(14) << entry.Inclusive * 1e-6
+				<< std::setprecision(3) << std::setw(12) << (entry.Count ? entry.Inclusive * 1e-3 / entry.Count : 0.0) << std::endl;
+		}
+		stream.unsetf(std::ios::floatfield);
+	}
+
+	//每个线程的调用树
+	void PrintTree(std::ostream& stream = std::cout)
+	{
+		for (auto& tree : GetTrees())
+		{
+			std::lock_guard<std::mutex> lock(tree->Mutex);
+			stream << "thread " << tree->ThreadID << std::endl;
+			for (auto& root : tree->Root.Children)
+				PrintNode(stream, *root, 1);
+		}
+	}
+
+private:
+	struct ThreadTree
+	{
+		std::mutex Mutex; //保护Children的结构（新建节点、Report读）
+		Node Root;
+		Node* Current = &Root;
+		uint32_t ThreadID = 0;
+	};
+
+	TimingTree() = default;
+
+	static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	ThreadTree& GetThreadTree()
+	{
+		//线程退出后树还留在m_Trees里，Report()依然能看到
+		static thread_local ThreadTree* t_Tree = nullptr;
+		if (!t_Tree)
+		{
+			auto tree = std::make_shared<ThreadTree>();
+			std::lock_guard<std::mutex> lock(m_RegistryMutex);
+			tree->ThreadID = (uint32_t)m_Trees.size();
+			m_Trees.push_back(tree);
+			t_Tree = tree.get();
+		}
+		return *t_Tree;
+	}
+
+	std::vector<std::shared_ptr<ThreadTree>> GetTrees()
+	{
+		std::lock_guard<std::mutex> lock(m_RegistryMutex);
+		return m_Trees;
+	}
+
+	template<typename Fn>
+	static void Collect(const Node& node, std::vector<const char*>& stack, Fn&& fn)
+	{
+		bool recursive = std::any_of(stack.begin(), stack.end(), [&](const char* name) { return strcmp(name, node.Name) == 0; });
+		fn(node, recursive);
+
+		stack.push_back(node.Name);
+		for (auto& child : node.Children)
+			Collect(*child, stack, fn);
+		stack.pop_back();
+	}
+
+	static void PrintNode(std::ostream& stream, const Node& node, int depth)
+	{
+		stream << std::string(depth * 2, ' ') << node.Name
+			<< "  count " << node.Count.load(std::memory_order_relaxed)
+			<< ", incl " << node.InclusiveNanoseconds.load(std::memory_order_relaxed) * 1e-6 << "ms"
+			<< ", self " << node.SelfNanoseconds() * 1e-6 << "ms" << std::endl;
+		for (auto& child : node.Children)
+			PrintNode(stream, *child, depth + 1);
+	}
+
+	std::mutex m_RegistryMutex;
+	std::vector<std::shared_ptr<ThreadTree>> m_Trees;
+};
+
+class ScopedTiming
+{
+public:
+	explicit ScopedTiming(const char* name)
+		: m_Node(TimingTree::Get().Enter(name)), m_Start(TscClock::now())
+	{
+	}
+
+	~ScopedTiming()
+	{
+		//TSC在不同核上可能有一点偏差，线程换了核时结束可能比开始还早：按0算，不要转成一个巨大的无符号数
+		auto elapsed = TscClock::now() - m_Start;
+		TimingTree::Get().Exit(m_Node, elapsed.count() > 0 ? (uint64_t)elapsed.count() : 0);
+	}
+
+	ScopedTiming(const ScopedTiming&) = delete;
+	ScopedTiming& operator=(const ScopedTiming&) = delete;
+
+private:
+	TimingTree::Node* m_Node;
+	TscClock::time_point m_Start;
+};
+
+#define TIME_SCOPE_CONCAT_IMPL(a, b) a##b
+#define TIME_SCOPE_CONCAT(a, b) TIME_SCOPE_CONCAT_IMPL(a, b)
+#define TIME_SCOPE(name) ScopedTiming TIME_SCOPE_CONCAT(scopedTiming, __LINE__)(name)
+#define TIME_FUNCTION() TIME_SCOPE(__func__)
@@ -0,0 +1,210 @@
+#include "AllocationBenchmark.h"
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace benchmark
+{
+	namespace
+	{
+		template<size_t Size>
+		struct Object
+		{
+			char Data[Size];
+		};
+
+		struct ThreadResult
+		{
+			long long AllocNanoseconds = 0;
+			long long DestroyNanoseconds = 0;
+			uint64_t Allocations = 0;
+			uint64_t Bytes = 0;
+		};
+
+		template<typename Pointer, typename Make>
+		void RunThreads(uint64_t objectCount, unsigned int threads, Make make, std::vector<ThreadResult>& results)
+		{
+			std::atomic<unsigned int> ready = 0;
+			std::atomic<bool> go = false;
+			std::vector<std::thread> workers;
+
+			for (unsigned int t = 0; t < threads; t++)
+			{
+				uint64_t count = objectCount / threads + (t < objectCount % threads ? 1 : 0);
+				workers.emplace_back([&, t, count]()
+				{
+					std::vector<Pointer> pointers;
+					pointers.reserve(count);
+
+					ready++;
+					while (!go.load(std::memory_order_acquire))
+						std::this_thread::yield();
+
+					AllocationCounts before = ThreadAllocations();
+
+					Timer timer(false);
+					for (uint64_t i = 0; i < count; i++)
+						pointers.push_back(make());
+					ClobberMemory();
+					timer.Stop();
+
+					results[t].AllocNanoseconds = timer.ElapsedNanoseconds();
+					AllocationCounts after = ThreadAllocations();
+					results[t].Allocations = after.Count - before.Count;
+					results[t].Bytes = after.Bytes - before.Bytes;
+
+					timer.Reset();
+					pointers.clear();
+					ClobberMemory();
+					timer.Stop();
+					results[t].DestroyNanoseconds = timer.ElapsedNanoseconds();
+				});
+			}
+
+			while (ready.load() != threads)
+				std::this_thread::yield();
+			go.store(true, std::memory_order_release);
+
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+
+		template<size_t Size>
+		void RunKind(AllocKind kind, uint64_t objectCount, unsigned int threads, std::vector<ThreadResult>& results)
+		{
+			using T = Object<Size>;
+			switch (kind)
+			{
+			case AllocKind::MakeShared:
+				RunThreads<std::shared_ptr<T>>(objectCount, threads, []() { return std::make_shared<T>(); }, results);
+				break;
+			case AllocKind::SharedNew:
+				RunThreads<std::shared_ptr<T>>(objectCount, threads, []() { return std::shared_ptr<T>(new T()); }, results);
+				break;
+			case AllocKind::MakeUnique:
+				RunThreads<std::unique_ptr<T>>(objectCount, threads, []() { return std::make_unique<T>(); }, results);
+				break;
+			}
+		}
+
+		void RunOnce(AllocKind kind, size_t objectSize, uint64_t objectCount, unsigned int threads, std::vector<ThreadResult>& results)
+		{
+			switch (objectSize)
+			{
+			case 8:    RunKind<8>(kind, objectCount, threads, results); break;
+			case 16:   RunKind<16>(kind, objectCount, threads, results); break;
+			case 32:   RunKind<32>(kind, objectCount, threads, results); break;
+			case 64:   RunKind<64>(kind, objectCount, threads, results); break;
+			case 128:  RunKind<128>(kind, objectCount, threads, results); break;
+			case 256:  RunKind<256>(kind, objectCount, threads, results); break;
+			case 1024: RunKind<1024>(kind, objectCount, threads, results); break;
+			default:
+				std::cout << "Unsupported object size " << objectSize << std::endl;
+				break;
+			}
+		}
+	}
+
+	const char* ToString(AllocKind kind)
+	{
+		switch (kind)
+		{
+		case AllocKind::MakeShared: return "make_shared";
+		case AllocKind::SharedNew:  return "shared_ptr(new)";
+		case AllocKind::MakeUnique: return "make_unique";
+		}
+		return "unknown";
+	}
+
+	AllocationResult MeasureAllocation(AllocKind kind, size_t objectSize, uint64_t objectCount, unsigned int threads, int repetitions)
+	{
+		std::vector<double> allocSamples, destroySamples;
+		uint64_t allocations = 0, bytes = 0;
+
+		//只在这里数分配次数，其他benchmark测的还是没有计数的operator new
+		ScopedAllocationCounting counting;
+
+		for (int r = 0; r < repetitions; r++)
+		{
+			std::vector<ThreadResult> results(threads);
+			RunOnce(kind, objectSize, objectCount, threads, results);
+
+			//所有线程同时开始，最慢的那个就是墙上时间
+			long long allocWall = 0, destroyWall = 0;
+			allocations = bytes = 0;
+			for (const ThreadResult& result : results)
+			{
+				allocWall = std::max(allocWall, result.AllocNanoseconds);
+				destroyWall = std::max(destroyWall, result.DestroyNanoseconds);
+				allocations += result.Allocations;
+				bytes += result.Bytes;
+			}
+			allocSamples.push_back((double)allocWall);
+			destroySamples.push_back((double)destroyWall);
+		}
+
+		Stats alloc = Summarize(ToString(kind), allocSamples, 1);
+		Stats destroy = Summarize(ToString(kind), destroySamples, 1);
+
+		AllocationResult result;
+		result.Kind = kind;
+		result.ObjectSize = objectSize;
+		result.ObjectCount = objectCount;
+		result.Threads = threads;
+		result.AllocMilliseconds = alloc.Median * 1e-6;
+		result.DestroyMilliseconds = destroy.Median * 1e-6;
+		result.AllocsPerSecond = alloc.Median > 0.0 ? objectCount / (alloc.Median * 1e-9) : 0.0;
+		result.BytesPerObject = objectCount ? (double)bytes / objectCount : 0.0;
+		result.Allocations = allocations;
+		result.Alloc = alloc;
+		return result;
+	}
+
+	std::vector<AllocationResult> RunAllocationSuite(const AllocationSuiteOptions& options)
+	{
+		std::vector<unsigned int> threadCounts = options.ThreadCounts;
+		if (threadCounts.empty())
+		{
+			unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+			for (unsigned int t = 1; t < cores; t *= 2)
+				threadCounts.push_back(t);
+			threadCounts.push_back(cores);
+		}
+
+		std::cout << std::left << std::setw(16) << "kind" << std::right
+			<< std::setw(6) << "size" << std::setw(10) << "count" << std::setw(8) << "threads"
+			<< std::setw(12) << "alloc ms" << std::setw(14) << "allocs/s"
+			<< std::setw(12) << "bytes/obj" << std::setw(12) << "news/obj" << std::setw(12) << "destroy ms" << std::endl;
+
+		std::vector<AllocationResult> results;
+		for (size_t size : options.ObjectSizes)
+		{
+			for (uint64_t count : options.ObjectCounts)
+			{
+				for (unsigned int threads : threadCounts)
+				{
+					for (AllocKind kind : { AllocKind::MakeShared, AllocKind::SharedNew, AllocKind::MakeUnique })
+					{
+						AllocationResult r = MeasureAllocation(kind, size, count, threads, options.Repetitions);
+						results.push_back(r);
+
+						std::cout << std::left << std::setw(16) << ToString(kind) << std::right << std::fixed
+							<< std::setw(6) << r.ObjectSize << std::setw(10) << r.ObjectCount << std::setw(8) << r.Threads
+							<< std::setprecision(3) << std::setw(12) << r.AllocMilliseconds
+							<< std::setprecision(0) << std::setw(14) << r.AllocsPerSecond
+							<< std::setprecision(1) << std::setw(12) << r.BytesPerObject
+							<< std::setprecision(2) << std::setw(12) << (double)r.Allocations / r.ObjectCount
+							<< std::setprecision(3) << std::setw(12) << r.DestroyMilliseconds << std::endl;
+						std::cout.unsetf(std::ios::floatfield);
+					}
+				}
+			}
+		}
+		return results;
+	}
+}
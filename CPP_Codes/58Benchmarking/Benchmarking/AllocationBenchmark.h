@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Benchmark.h"
+
+//多线程下比较 make_shared / shared_ptr(new) / make_unique：
+//对象大小 x 对象数量 x 线程数 全部扫一遍，报告分配吞吐、分配的字节数以及析构的开销。
+namespace benchmark
+{
+	enum class AllocKind
+	{
+		MakeShared, SharedNew, MakeUnique
+	};
+
+	struct AllocationSuiteOptions
+	{
+		std::vector<size_t> ObjectSizes = { 8, 64, 256 };
+		std::vector<uint64_t> ObjectCounts = { 1'000, 10'000, 100'000, 1'000'000, 10'000'000 }; //所有线程加起来的总数
+		std::vector<unsigned int> ThreadCounts; //为空时：1, 2, 4, ... 直到硬件线程数
+		int Repetitions = 5;
+	};
+
+	struct AllocationResult
+	{
+		AllocKind Kind;
+		size_t ObjectSize;
+		uint64_t ObjectCount;
+		unsigned int Threads;
+		double AllocMilliseconds;   //median wall time
+		double DestroyMilliseconds; //median wall time
+		double AllocsPerSecond;
+		double BytesPerObject;      //operator new实际拿到的字节数，包括控制块
+		uint64_t Allocations;       //operator new调用次数
+		Stats Alloc;                //每次重复的分配墙上时间(ns)，给baseline比较用
+	};
+
+	const char* ToString(AllocKind kind);
+
+	//单次测量（多次重复取median）
+	AllocationResult MeasureAllocation(AllocKind kind, size_t objectSize, uint64_t objectCount, unsigned int threads, int repetitions);
+
+	std::vector<AllocationResult> RunAllocationSuite(const AllocationSuiteOptions& options = AllocationSuiteOptions());
+}
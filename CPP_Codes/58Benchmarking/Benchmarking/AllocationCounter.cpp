@@ -0,0 +1,112 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace
+{
+	std::atomic<int> s_CountingScopes{ 0 };
+	thread_local uint64_t t_AllocationCount = 0;
+	thread_local uint64_t t_AllocatedBytes = 0;
+
+	void Count(size_t size)
+	{
+		if (s_CountingScopes.load(std::memory_order_relaxed) > 0)
+		{
+			t_AllocationCount++;
+			t_AllocatedBytes += size;
+		}
+	}
+
+	void* Allocate(size_t size) noexcept
+	{
+		Count(size);
+		return std::malloc(size ? size : 1);
+	}
+
+	void* AllocateAligned(size_t size, std::align_val_t alignment) noexcept
+	{
+		Count(size);
+		size_t align = (size_t)alignment;
+#if defined(_MSC_VER)
+		return _aligned_malloc(size ? size : 1, align);
+#else
+		//aligned_alloc要求size是alignment的整数倍
+		size_t rounded = (size + align - 1) / align * align;
+		return std::aligned_alloc(align, rounded ? rounded : align);
+#endif
+	}
+
+	void Free(void* memory) noexcept
+	{
+		std::free(memory);
+	}
+
+	//_aligned_malloc拿到的内存必须用_aligned_free还
+	void FreeAligned(void* memory) noexcept
+	{
+#if defined(_MSC_VER)
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+
+	void* OrThrow(void* memory)
+	{
+		if (!memory)
+			throw std::bad_alloc();
+		return memory;
+	}
+}
+
+namespace benchmark
+{
+	AllocationCounts ThreadAllocations()
+	{
+		AllocationCounts counts;
+		counts.Count = t_AllocationCount;
+		counts.Bytes = t_AllocatedBytes;
+		return counts;
+	}
+
+	ScopedAllocationCounting::ScopedAllocationCounting()
+	{
+		s_CountingScopes.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	ScopedAllocationCounting::~ScopedAllocationCounting()
+	{
+		s_CountingScopes.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void* operator new(size_t size) { return OrThrow(Allocate(size)); }
+void* operator new[](size_t size) { return OrThrow(Allocate(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return OrThrow(AllocateAligned(size, alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return OrThrow(AllocateAligned(size, alignment)); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return AllocateAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { Free(memory); }
+void operator delete[](void* memory) noexcept { Free(memory); }
+void operator delete(void* memory, size_t) noexcept { Free(memory); }
+void operator delete[](void* memory, size_t) noexcept { Free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { Free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { Free(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(memory); }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+//统计堆分配次数：AllocationCounter.cpp替换了全局operator new/delete的所有形式（数组、对齐、nothrow），
+//想数分配次数的程序把它加进自己的工程就行。一个程序里只能有一份全局operator new，不要再自己写一份。
+//
+//平时不计数，operator new只比默认的多读一次标志；ScopedAllocationCounting活着的时候才累加，
+//所以同一个程序里其他的benchmark测到的还是原来的分配器：
+//	benchmark::ScopedAllocationCounting counting;
+//	benchmark::AllocationCounts before = benchmark::ThreadAllocations();
+//	...
+//	uint64_t allocations = benchmark::ThreadAllocations().Count - before.Count;
+namespace benchmark
+{
+	struct AllocationCounts
+	{
+		uint64_t Count = 0; //operator new调用次数
+		uint64_t Bytes = 0; //请求的字节数
+	};
+
+	//本线程在计数打开期间的累计值。每个线程一份，计数本身不会变成线程间的争用点
+	AllocationCounts ThreadAllocations();
+
+	//作用域内打开计数（对所有线程），可以嵌套
+	class ScopedAllocationCounting
+	{
+	public:
+		ScopedAllocationCounting();
+		~ScopedAllocationCounting();
+
+		ScopedAllocationCounting(const ScopedAllocationCounting&) = delete;
+		ScopedAllocationCounting& operator=(const ScopedAllocationCounting&) = delete;
+	};
+}
@@ -0,0 +1,315 @@
+#include "Baseline.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace benchmark
+{
+	namespace
+	{
+		//CSV里不能出现逗号和换行
+		std::string Sanitize(std::string value)
+		{
+			for (char& c : value)
+			{
+				if (c == ',')
+					c = ';';
+				else if (c == '\n' || c == '\r')
+					c = ' ';
+			}
+			return value;
+		}
+
+		std::vector<std::string> Split(const std::string& line, char separator)
+		{
+			std::vector<std::string> fields;
+			std::stringstream stream(line);
+			std::string field;
+			while (std::getline(stream, field, separator))
+				fields.push_back(field);
+			if (!line.empty() && line.back() == separator)
+				fields.push_back("");
+			return fields;
+		}
+
+		std::string CpuBrand()
+		{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+			unsigned int regs[12] = {};
+			for (unsigned int i = 0; i < 3; i++)
+			{
+#if defined(_MSC_VER)
+				__cpuid((int*)&regs[i * 4], 0x80000002 + i);
+#else
+				__get_cpuid(0x80000002 + i, &regs[i * 4], &regs[i * 4 + 1], &regs[i * 4 + 2], &regs[i * 4 + 3]);
+#endif
+			}
+			std::string brand((const char*)regs, sizeof(regs));
+			brand = brand.c_str(); //去掉结尾的\0
+			size_t first = brand.find_first_not_of(' ');
+			return first == std::string::npos ? "unknown" : brand.substr(first);
+#else
+			return "unknown";
+#endif
+		}
+
+		std::string HostName()
+		{
+#if defined(_WIN32)
+			const char* name = std::getenv("COMPUTERNAME");
+			return name ? name : "unknown";
+#else
+			char name[256] = {};
+			if (gethostname(name, sizeof(name) - 1) != 0)
+				return "unknown";
+			return name;
+#endif
+		}
+
+		//正则化不完全beta函数 I_x(a, b)，连分式展开（Numerical Recipes betacf）
+		double BetaContinuedFraction(double a, double b, double x)
+		{
+			const int maxIterations = 200;
+			const double epsilon = 3e-14, tiny = 1e-300;
+
+			double qab = a + b, qap = a + 1.0, qam = a - 1.0;
+			double c = 1.0, d = 1.0 - qab * x / qap;
+			if (std::fabs(d) < tiny)
+				d = tiny;
+			d = 1.0 / d;
+			double h = d;
+
+			for (int m = 1; m <= maxIterations; m++)
+			{
+				int m2 = 2 * m;
+				double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+				d = 1.0 + aa * d;
+				if (std::fabs(d) < tiny)
+					d = tiny;
+				c = 1.0 + aa / c;
+				if (std::fabs(c) < tiny)
+					c = tiny;
+				d = 1.0 / d;
+				h *= d * c;
+
+				aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+				d = 1.0 + aa * d;
+				if (std::fabs(d) < tiny)
+					d = tiny;
+				c = 1.0 + aa / c;
+				if (std::fabs(c) < tiny)
+					c = tiny;
+				d = 1.0 / d;
+				double delta = d * c;
+				h *= delta;
+				if (std::fabs(delta - 1.0) < epsilon)
+					break;
+			}
+			return h;
+		}
+
+		double IncompleteBeta(double a, double b, double x)
+		{
+			if (x <= 0.0)
+				return 0.0;
+			if (x >= 1.0)
+				return 1.0;
+
+			double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+			if (x < (a + 1.0) / (a + b + 2.0))
+				return front * BetaContinuedFraction(a, b, x) / a;
+			return 1.0 - front * BetaContinuedFraction(b, a, 1.0 - x) / b;
+		}
+	}
+
+	MachineFingerprint MachineFingerprint::Current()
+	{
+		MachineFingerprint machine;
+		machine.Host = HostName();
+		machine.Cpu = CpuBrand();
+		machine.Cores = std::thread::hardware_concurrency();
+#if defined(_MSC_VER)
+		machine.Compiler = "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+		machine.Compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+		machine.Compiler = "gcc " __VERSION__;
+#else
+		machine.Compiler = "unknown";
+#endif
+#if defined(NDEBUG)
+		machine.Build = "Release";
+#else
+		machine.Build = "Debug";
+#endif
+		return machine;
+	}
+
+	std::ostream& operator<<(std::ostream& stream, const MachineFingerprint& machine)
+	{
+		return stream << machine.Host << " | " << machine.Cpu << " | " << machine.Cores << " threads | "
+			<< machine.Compiler << " | " << machine.Build;
+	}
+
+	void Baseline::Add(const Stats& stats, const std::string& parameters)
+	{
+		Records.push_back({ stats.Name, parameters, stats });
+	}
+
+	const BaselineRecord* Baseline::Find(const std::string& name, const std::string& parameters) const
+	{
+		for (const BaselineRecord& record : Records)
+		{
+			if (record.Name == name && record.Parameters == parameters)
+				return &record;
+		}
+		return nullptr;
+	}
+
+	bool Baseline::Save(const std::string& filepath) const
+	{
+		std::ofstream stream(filepath);
+		if (!stream)
+			return false;
+
+		stream << "#machine," << Sanitize(Machine.Host) << "," << Sanitize(Machine.Cpu) << "," << Machine.Cores << ","
+			<< Sanitize(Machine.Compiler) << "," << Sanitize(Machine.Build) << "\n";
+		stream << "name,parameters,iterations,samples,min,median,p90,p99,mean,stddev\n";
+		stream << std::setprecision(17);
+		for (const BaselineRecord& record : Records)
+		{
+			const Stats& s = record.Result;
+			stream << Sanitize(record.Name) << "," << Sanitize(record.Parameters) << "," << s.Iterations << "," << s.Samples << ","
+				<< s.Min << "," << s.Median << "," << s.P90 << "," << s.P99 << "," << s.Mean << "," << s.StdDev << "\n";
+		}
+		return (bool)stream;
+	}
+
+	bool Baseline::Load(const std::string& filepath, Baseline& baseline)
+	{
+		std::ifstream stream(filepath);
+		if (!stream)
+			return false;
+
+		baseline.Records.clear();
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (line.empty() || line.rfind("name,", 0) == 0)
+				continue;
+
+			std::vector<std::string> fields = Split(line, ',');
+			if (fields[0] == "#machine")
+			{
+				if (fields.size() < 6)
+					return false;
+				baseline.Machine.Host = fields[1];
+				baseline.Machine.Cpu = fields[2];
+				baseline.Machine.Cores = (unsigned int)std::strtoul(fields[3].c_str(), nullptr, 10);
+				baseline.Machine.Compiler = fields[4];
+				baseline.Machine.Build = fields[5];
+				continue;
+			}
+			if (fields.size() < 10)
+				return false;
+
+			BaselineRecord record;
+			record.Name = fields[0];
+			record.Parameters = fields[1];
+			record.Result.Name = fields[0];
+			record.Result.Iterations = std::strtoull(fields[2].c_str(), nullptr, 10);
+			record.Result.Samples = (size_t)std::strtoull(fields[3].c_str(), nullptr, 10);
+			record.Result.Min = std::strtod(fields[4].c_str(), nullptr);
+			record.Result.Median = std::strtod(fields[5].c_str(), nullptr);
+			record.Result.P90 = std::strtod(fields[6].c_str(), nullptr);
+			record.Result.P99 = std::strtod(fields[7].c_str(), nullptr);
+			record.Result.Mean = std::strtod(fields[8].c_str(), nullptr);
+			record.Result.StdDev = std::strtod(fields[9].c_str(), nullptr);
+			baseline.Records.push_back(record);
+		}
+		return true;
+	}
+
+	double WelchTTestPValue(double mean1, double stddev1, size_t n1, double mean2, double stddev2, size_t n2)
+	{
+		if (n1 < 2 || n2 < 2)
+			return 1.0;
+
+		double v1 = stddev1 * stddev1 / n1, v2 = stddev2 * stddev2 / n2;
+		double se = std::sqrt(v1 + v2);
+		if (se == 0.0)
+			return mean2 > mean1 ? 0.0 : 1.0;
+
+		double t = (mean2 - mean1) / se;
+		double df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+
+		//Student t分布的尾部概率：P(|T| >= |t|) = I_{df/(df+t^2)}(df/2, 1/2)
+		double tail = 0.5 * IncompleteBeta(df / 2.0, 0.5, df / (df + t * t));
+		return t > 0.0 ? tail : 1.0 - tail;
+	}
+
+	std::vector<Comparison> Compare(const Baseline& baseline, const Baseline& current, const CompareOptions& options)
+	{
+		std::vector<Comparison> comparisons;
+		for (const BaselineRecord& record : current.Records)
+		{
+			const BaselineRecord* base = baseline.Find(record.Name, record.Parameters);
+			if (!base)
+				continue;
+
+			const Stats& a = base->Result;
+			const Stats& b = record.Result;
+
+			Comparison comparison;
+			comparison.Name = record.Name;
+			comparison.Parameters = record.Parameters;
+			comparison.BaselineMean = a.Mean;
+			comparison.CurrentMean = b.Mean;
+			comparison.Change = a.Mean > 0.0 ? b.Mean / a.Mean - 1.0 : 0.0;
+			comparison.PValue = WelchTTestPValue(a.Mean, a.StdDev, a.Samples, b.Mean, b.StdDev, b.Samples);
+			comparison.Regression = comparison.PValue < options.Alpha && comparison.Change > options.MinChange;
+
+			double improvementPValue = WelchTTestPValue(b.Mean, b.StdDev, b.Samples, a.Mean, a.StdDev, a.Samples);
+			comparison.Improvement = improvementPValue < options.Alpha && comparison.Change < -options.MinChange;
+			comparisons.push_back(comparison);
+		}
+		return comparisons;
+	}
+
+	int PrintComparison(const std::vector<Comparison>& comparisons, std::ostream& stream)
+	{
+		int regressions = 0;
+		stream << std::left << std::setw(28) << "benchmark" << std::setw(30) << "parameters" << std::right
+			<< std::setw(14) << "baseline ns" << std::setw(14) << "current ns" << std::setw(10) << "change" << std::setw(10) << "p" << "  result" << std::endl;
+		for (const Comparison& c : comparisons)
+		{
+			const char* verdict = c.Regression ? "SLOWER" : (c.Improvement ? "faster" : "same");
+			if (c.Regression)
+				regressions++;
+
+			stream << std::left << std::setw(28) << c.Name << std::setw(30) << c.Parameters << std::right << std::fixed
+				<< std::setprecision(2) << std::setw(14) << c.BaselineMean << std::setw(14) << c.CurrentMean
+				<< std::setprecision(1) << std::setw(9) << c.Change * 100.0 << "%"
+				<< std::setprecision(4) << std::setw(10) << c.PValue << "  " << verdict << std::endl;
+		}
+		stream.unsetf(std::ios::floatfield);
+		stream << regressions << " regression(s)" << std::endl;
+		return regressions;
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+//把benchmark结果存成baseline文件（CSV），下次跑完和baseline比较：
+//均值变慢超过MinChange，并且Welch t检验（单侧）显著时算回归，compare模式以非0退出。
+namespace benchmark
+{
+	struct MachineFingerprint
+	{
+		std::string Host;
+		std::string Cpu;
+		std::string Compiler;
+		std::string Build;
+		unsigned int Cores = 0;
+
+		static MachineFingerprint Current();
+
+		bool operator==(const MachineFingerprint& other) const
+		{
+			return Cpu == other.Cpu && Compiler == other.Compiler && Build == other.Build && Cores == other.Cores;
+		}
+		bool operator!=(const MachineFingerprint& other) const { return !(*this == other); }
+	};
+
+	std::ostream& operator<<(std::ostream& stream, const MachineFingerprint& machine);
+
+	struct BaselineRecord
+	{
+		std::string Name;
+		std::string Parameters; //key=value;key=value
+		Stats Result;
+	};
+
+	class Baseline
+	{
+	public:
+		MachineFingerprint Machine = MachineFingerprint::Current();
+		std::vector<BaselineRecord> Records;
+
+		void Add(const Stats& stats, const std::string& parameters = "");
+		const BaselineRecord* Find(const std::string& name, const std::string& parameters) const;
+
+		bool Save(const std::string& filepath) const;
+		static bool Load(const std::string& filepath, Baseline& baseline);
+	};
+
+	struct CompareOptions
+	{
+		double Alpha = 0.01;     //显著性水平
+		double MinChange = 0.05; //均值至少变慢5%才算，太小的差别即使显著也不关心
+	};
+
+	struct Comparison
+	{
+		std::string Name;
+		std::string Parameters;
+		double BaselineMean = 0.0;
+		double CurrentMean = 0.0;
+		double Change = 0.0; //current / baseline - 1
+		double PValue = 1.0; //H1: current比baseline慢
+		bool Regression = false;
+		bool Improvement = false;
+	};
+
+	//Welch t检验的单侧p值：P(T >= t)，t = (mean2 - mean1) / se
+	double WelchTTestPValue(double mean1, double stddev1, size_t n1, double mean2, double stddev2, size_t n2);
+
+	std::vector<Comparison> Compare(const Baseline& baseline, const Baseline& current, const CompareOptions& options = CompareOptions());
+
+	//返回回归的个数
+	int PrintComparison(const std::vector<Comparison>& comparisons, std::ostream& stream = std::cout);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Timer.h"
+
+namespace benchmark
+{
+	//编译器看到结果没被使用，就会把整段计算删掉（见Benchmarking.cpp开头的value += 2）。
+	//DoNotOptimize让value"逃逸"出去，编译器必须真的把它算出来。
+	template<typename T>
+	inline void DoNotOptimize(T const& value)
+	{
+#if defined(_MSC_VER)
+		static const volatile void* s_Sink;
+		s_Sink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+
+	//ClobberMemory告诉编译器所有内存都可能被读写了，之前的store不能被合并或删掉。
+	inline void ClobberMemory()
+	{
+#if defined(_MSC_VER)
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : : "memory");
+#endif
+	}
+
+	struct Options
+	{
+		int WarmupRuns = 3;
+		int Samples = 30;
+		long long MinSampleNanoseconds = 2'000'000; //每个sample至少跑2ms，小于这个时间计时器本身的误差太大
+		uint64_t MaxIterations = 1ull << 30;
+		PerfCounters* Counters = nullptr; //不为空时采样阶段同时统计硬件计数器
+	};
+
+	//所有时间都是单次迭代的纳秒数
+	struct Stats
+	{
+		std::string Name;
+		uint64_t Iterations = 0; //每个sample里跑了多少次
+		size_t Samples = 0;
+		double Min = 0.0;
+		double Median = 0.0;
+		double P90 = 0.0;
+		double P99 = 0.0;
+		double Mean = 0.0;
+		double StdDev = 0.0;
+		PerfCounters::Values Counters; //采样阶段所有迭代的总数
+		uint64_t CounterIterations = 0;
+	};
+
+	namespace detail
+	{
+		template<typename Fn>
+		long long RunBatch(Fn& fn, uint64_t iterations, PerfCounters* counters = nullptr, PerfCounters::Values* values = nullptr)
+		{
+			Timer timer(false, counters);
+			for (uint64_t i = 0; i < iterations; i++)
+				fn();
+			timer.Stop();
+			if (values)
+				*values += timer.CounterValues();
+			return timer.ElapsedNanoseconds();
+		}
+
+		//nearest-rank percentile，samples必须已排序
+		inline double Percentile(const std::vector<double>& samples, double p)
+		{
+			size_t rank = (size_t)std::ceil(p * samples.size());
+			return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+		}
+	}
+
+	inline Stats Summarize(std::string name, std::vector<double> samples, uint64_t iterations)
+	{
+		Stats stats;
+		stats.Name = std::move(name);
+		stats.Iterations = iterations;
+		stats.Samples = samples.size();
+		if (samples.empty())
+			return stats;
+
+		std::sort(samples.begin(), samples.end());
+		stats.Min = samples.front();
+		stats.Median = detail::Percentile(samples, 0.50);
+		stats.P90 = detail::Percentile(samples, 0.90);
+		stats.P99 = detail::Percentile(samples, 0.99);
+
+		double sum = 0.0;
+		for (double s : samples)
+			sum += s;
+		stats.Mean = sum / samples.size();
+
+		double variance = 0.0;
+		for (double s : samples)
+			variance += (s - stats.Mean) * (s - stats.Mean);
+		if (samples.size() > 1)
+			variance /= (samples.size() - 1);
+		stats.StdDev = std::sqrt(variance);
+
+		return stats;
+	}
+
+	//先warmup，再自动把迭代次数调到一个sample >= MinSampleNanoseconds，最后采Samples个样本
+	template<typename Fn>
+	Stats Run(const std::string& name, Fn&& fn, const Options& options = Options())
+	{
+		for (int i = 0; i < options.WarmupRuns; i++)
+			fn();
+
+		uint64_t iterations = 1;
+		while (iterations < options.MaxIterations)
+		{
+			long long elapsed = detail::RunBatch(fn, iterations);
+			if (elapsed >= options.MinSampleNanoseconds)
+				break;
+
+			//按比例估计还差多少，多乘一点余量；太快(0ns)就直接x10
+			uint64_t next = elapsed > 0
+				? (uint64_t)(iterations * 1.4 * options.MinSampleNanoseconds / elapsed)
+				: iterations * 10;
+			iterations = std::min(std::max(next, iterations * 2), options.MaxIterations);
+		}
+
+		PerfCounters* counters = options.Counters && options.Counters->IsAvailable() ? options.Counters : nullptr;
+		PerfCounters::Values values;
+
+		std::vector<double> samples;
+		samples.reserve(options.Samples);
+		for (int i = 0; i < options.Samples; i++)
+			samples.push_back((double)detail::RunBatch(fn, iterations, counters, &values) / iterations);
+
+		Stats stats = Summarize(name, std::move(samples), iterations);
+		if (counters)
+		{
+			stats.Counters = values;
+			stats.CounterIterations = iterations * options.Samples;
+		}
+		return stats;
+	}
+
+	inline void Print(const Stats& stats, std::ostream& stream = std::cout)
+	{
+		stream << std::left << std::setw(28) << stats.Name << std::right << std::fixed << std::setprecision(2)
+			<< " min " << std::setw(10) << stats.Min
+			<< " median " << std::setw(10) << stats.Median
+			<< " p90 " << std::setw(10) << stats.P90
+			<< " p99 " << std::setw(10) << stats.P99
+			<< " stddev " << std::setw(8) << stats.StdDev
+			<< " ns/iter (" << stats.Iterations << " iters x " << stats.Samples << " samples)";
+		stream.unsetf(std::ios::floatfield);
+		if (stats.CounterIterations > 0)
+			PerfCounters::Print(stats.Counters, stats.CounterIterations, stream);
+		stream << std::endl;
+	}
+}
@@ -1,40 +1,171 @@
 ﻿#include <iostream>
 #include <chrono>
 #include <array>
+#include <memory>
+#include <cstring>
+#include <thread>
 
-class Timer
+#include "Timer.h"
+#include "Benchmark.h"
+#include "AllocationBenchmark.h"
+#include "Instrumentor.h"
+#include "Baseline.h"
+
+struct Vector2
 {
-public:
-	Timer()
+	float x, y;
+};
+
+//每个线程各自分配一遍，结果写进results.json，用chrome://tracing打开对比各线程的时间线
+void TraceAllocations()
+{
+	PROFILE_FUNCTION();
+
+	for (int run = 0; run < 10; run++)
 	{
-		m_StartTimepoint = std::chrono::high_resolution_clock::now();
+		{
+			PROFILE_SCOPE("make_shared");
+			std::array<std::shared_ptr<Vector2>, 1000> sharedPtrs;
+			for (size_t i = 0; i < sharedPtrs.size(); i++)
+				sharedPtrs[i] = std::make_shared<Vector2>();
+		}
+		{
+			PROFILE_SCOPE("shared_ptr(new)");
+			std::array<std::shared_ptr<Vector2>, 1000> sharedPtrs;
+			for (size_t i = 0; i < sharedPtrs.size(); i++)
+				sharedPtrs[i] = std::shared_ptr<Vector2>(new Vector2());
+		}
+		{
+			PROFILE_SCOPE("make_unique");
+			std::array<std::unique_ptr<Vector2>, 1000> uniquePtrs;
+			for (size_t i = 0; i < uniquePtrs.size(); i++)
+				uniquePtrs[i] = std::make_unique<Vector2>();
+		}
 	}
-	~Timer()
+}
+
+//用Benchmark.h：warmup + 自动校准迭代次数 + 多次采样，看min/median/p90/p99/stddev
+std::vector<benchmark::Stats> RunHarnessBenchmarks(const benchmark::Options& options)
+{
+	std::vector<benchmark::Stats> results;
+
+	results.push_back(benchmark::Run("value += 2 (x100000)", []()
 	{
-		Stop();
-	}
+		int value = 0;
+		for (int i = 0; i < 100000; i++)
+		{
+			value += 2;
+			benchmark::DoNotOptimize(value);
+		}
+	}, options));
+
+	std::array<std::shared_ptr<Vector2>, 1000> sharedPtrs;
+	std::array<std::unique_ptr<Vector2>, 1000> uniquePtrs;
 
-	void Stop()
+	results.push_back(benchmark::Run("make_shared (x1000)", [&]()
 	{
-		m_EndTimepoint = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < sharedPtrs.size(); i++)
+			sharedPtrs[i] = std::make_shared<Vector2>();
+		benchmark::ClobberMemory();
+	}, options));
+	results.push_back(benchmark::Run("shared_ptr(new) (x1000)", [&]()
+	{
+		for (size_t i = 0; i < sharedPtrs.size(); i++)
+			sharedPtrs[i] = std::shared_ptr<Vector2>(new Vector2());
+		benchmark::ClobberMemory();
+	}, options));
+	results.push_back(benchmark::Run("make_unique (x1000)", [&]()
+	{
+		for (size_t i = 0; i < uniquePtrs.size(); i++)
+			uniquePtrs[i] = std::make_unique<Vector2>();
+		benchmark::ClobberMemory();
+	}, options));
 
-		auto start = std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch().count();
-		auto end = std::chrono::time_point_cast<std::chrono::microseconds>(m_EndTimepoint).time_since_epoch().count();
+	return results;
+}
 
-		auto duration = end - start;
+//baseline：--save把结果写进文件，--compare和文件里的结果比较，显著变慢时返回1
+int RunBaselineMode(const char* mode, const char* filepath)
+{
+	benchmark::Baseline current;
+	PerfCounters counters;
+	benchmark::Options options;
+	options.Counters = &counters;
 
-		double ms = duration * 0.001;
+	for (const benchmark::Stats& stats : RunHarnessBenchmarks(options))
+	{
+		benchmark::Print(stats);
+		current.Add(stats);
+	}
 
-		std::cout << duration << "us (" << ms << "ms)" << std::endl;
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads : { 1u, cores })
+	{
+		for (benchmark::AllocKind kind : { benchmark::AllocKind::MakeShared, benchmark::AllocKind::SharedNew, benchmark::AllocKind::MakeUnique })
+		{
+			benchmark::AllocationResult result = benchmark::MeasureAllocation(kind, 64, 100000, threads, 15);
+			benchmark::Print(result.Alloc);
+			current.Add(result.Alloc, "size=64;count=100000;threads=" + std::to_string(threads));
+		}
+		if (cores == 1)
+			break;
 	}
 
-private:
-	std::chrono::time_point<std::chrono::high_resolution_clock> m_StartTimepoint, m_EndTimepoint;
-};
+	if (strcmp(mode, "--save") == 0)
+	{
+		if (!current.Save(filepath))
+		{
+			std::cout << "Failed to write baseline " << filepath << std::endl;
+			return 2;
+		}
+		std::cout << "Baseline written to " << filepath << std::endl;
+		return 0;
+	}
+
+	benchmark::Baseline baseline;
+	if (!benchmark::Baseline::Load(filepath, baseline))
+	{
+		std::cout << "Failed to read baseline " << filepath << std::endl;
+		return 2;
+	}
+	if (baseline.Machine != current.Machine)
+	{
+		std::cout << "Warning: baseline was recorded on a different machine/build\n"
+			<< "  baseline: " << baseline.Machine << "\n"
+			<< "  current:  " << current.Machine << std::endl;
+	}
+
+	int regressions = benchmark::PrintComparison(benchmark::Compare(baseline, current));
+	return regressions > 0 ? 1 : 0;
+}
 
 //benchmarking:基准测试，当你写了一些代码，你想知道它实际 运行 有多快，和过去的方法做个比较，看看哪个更快。基准测试的答案不唯一。
-int main()
+int main(int argc, char** argv)
 {
+	//Benchmarking.exe --alloc：多线程分配测试（对象大小 x 数量 x 线程数），跑的时间比较长
+	if (argc > 1 && strcmp(argv[1], "--alloc") == 0)
+	{
+		benchmark::RunAllocationSuite();
+		return 0;
+	}
+
+	//Benchmarking.exe --save baseline.csv / --compare baseline.csv
+	if (argc > 2 && (strcmp(argv[1], "--save") == 0 || strcmp(argv[1], "--compare") == 0))
+		return RunBaselineMode(argv[1], argv[2]);
+
+	//Benchmarking.exe --trace：生成results.json
+	if (argc > 1 && strcmp(argv[1], "--trace") == 0)
+	{
+		Instrumentor::Get().BeginSession("Allocations", "results.json");
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < std::max(2u, std::thread::hardware_concurrency()); t++)
+			threads.emplace_back(TraceAllocations);
+		for (std::thread& thread : threads)
+			thread.join();
+		Instrumentor::Get().EndSession();
+		return 0;
+	}
+
 	int value = 0;
 	{
 		Timer timer;
@@ -48,11 +179,6 @@ int main()
 
 	std::cout << "---------------------------------------------\n";
 
-	struct Vector2
-	{
-		float x, y;
-	};
-
 	std::cout << "Make shared\n";
 	{
 		std::array<std::shared_ptr<Vector2>, 1000> sharedPtrs;
@@ -80,6 +206,51 @@ int main()
 			uniquePtrs[i] = std::make_unique<Vector2>();
 		}
 	}
+	//上面每种只跑了一次，结果受缓存、页错误、调度的影响很大，跑几次数字都不一样。
+
+	std::cout << "---------------------------------------------\n";
+
+	//硬件计数器：没有权限或者不是Linux时IsAvailable()为false，下面只打印时间
+	PerfCounters counters;
+	if (!counters.IsAvailable())
+		std::cout << "(hardware counters unavailable, timing only)\n";
+
+	std::cout << "Make shared (counters)\n";
+	{
+		std::array<std::shared_ptr<Vector2>, 1000> sharedPtrs;
+		Timer timer(true, &counters);
+		timer.SetIterations(sharedPtrs.size());
+		for (size_t i = 0; i < sharedPtrs.size(); i++)
+		{
+			sharedPtrs[i] = std::make_shared<Vector2>();
+		}
+	}
+
+	std::cout << "---------------------------------------------\n";
+
+	//用Benchmark.h：warmup + 自动校准迭代次数 + 多次采样，看min/median/p90/p99/stddev
+	benchmark::Options options;
+	options.Counters = &counters;
+
+	//时钟本身的开销：一次now()要多久。TscTimer用rdtsc，适合测很短的作用域
+	std::cout << "TSC clock: " << (TscClock::IsTscEnabled() ? "enabled, " : "unavailable (steady_clock fallback), ")
+		<< TscClock::TicksPerNanosecond() << " ticks/ns\n";
+	benchmark::Print(benchmark::Run("high_resolution_clock::now", []()
+	{
+		benchmark::DoNotOptimize(std::chrono::high_resolution_clock::now());
+	}));
+	benchmark::Print(benchmark::Run("TscClock::now", []()
+	{
+		benchmark::DoNotOptimize(TscClock::now());
+	}));
+	{
+		TscTimer timer;
+		for (int i = 0; i < 10; i++)
+			benchmark::DoNotOptimize(value += 2);
+	}
+
+	for (const benchmark::Stats& stats : RunHarnessBenchmarks(options))
+		benchmark::Print(stats);
 
 	std::cin.get();
 }
\ No newline at end of file
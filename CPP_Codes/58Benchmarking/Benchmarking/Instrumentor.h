@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Instrumentation profiler：每个PROFILE_SCOPE记录开始/结束时间和线程id，
+//最后写成Chrome trace_event格式的json，用chrome://tracing 或者 https://ui.perfetto.dev 打开就能看到每个线程的时间线。
+//
+//	Instrumentor::Get().BeginSession("Startup", "results.json");
+//	{ PROFILE_FUNCTION(); ... }
+//	Instrumentor::Get().EndSession();
+//
+//每个线程先把事件写进自己的buffer，满了才拿文件锁写一次，线程之间不会因为同一个std::cout/文件互相等待。
+
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+struct ProfileResult
+{
+	const char* Name; //必须是字符串字面量或者__FUNCSIG__这种静态字符串，不拷贝
+	double Start;     //距离session开始的微秒数
+	double End;
+	uint32_t ThreadID;
+};
+
+class Instrumentor
+{
+public:
+	static constexpr size_t FlushThreshold = 4096;
+
+	static Instrumentor& Get()
+	{
+		static Instrumentor instance;
+		return instance;
+	}
+
+	void BeginSession(const std::string& name, const std::string& filepath = "results.json")
+	{
+		std::lock_guard<std::mutex> lock(m_FileMutex);
+		if (m_Active)
+			EndSessionLocked();
+
+		//上一次session之外记录的事件不要混进来
+		{
+			std::lock_guard<std::mutex> registryLock(m_RegistryMutex);
+			for (auto& buffer : m_Buffers)
+			{
+				std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+				buffer->Events.clear();
+			}
+		}
+
+		m_OutputStream.open(filepath);
+		//ts/dur是微秒的double，默认只有6位有效数字：过了1秒就变成1.23457e+06，事件会挤在一起。固定保留到纳秒
+		m_OutputStream << std::fixed << std::setprecision(3);
+		m_OutputStream << "{\"otherData\": {},\"traceEvents\":[";
+		m_EventCount = 0;
+		m_SessionName = name;
+		//其它线程的Now()不拿锁：先写开始时间，再用release发布m_Active，看到active的线程一定也看到新的开始时间
+		m_SessionStart.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+		m_Active.store(true, std::memory_order_release);
+	}
+
+	//调用前应该先join掉还在写事件的线程，否则它们之后的事件就丢了
+	void EndSession()
+	{
+		std::lock_guard<std::mutex> lock(m_FileMutex);
+		EndSessionLocked();
+	}
+
+	double Now() const
+	{
+		std::chrono::steady_clock::duration start(m_SessionStart.load(std::memory_order_relaxed));
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch() - start).count();
+	}
+
+	bool IsActive() const { return m_Active.load(std::memory_order_acquire); }
+
+	void WriteProfile(const char* name, double start, double end)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::unique_lock<std::mutex> lock(buffer.Mutex); //只有本线程和flush会拿这个锁，基本不会竞争
+		buffer.Events.push_back({ name, start, end, buffer.ThreadID });
+		if (buffer.Events.size() < FlushThreshold)
+			return;
+
+		std::vector<ProfileResult> events;
+		events.swap(buffer.Events);
+		buffer.Events.reserve(FlushThreshold);
+		lock.unlock();
+
+		std::lock_guard<std::mutex> fileLock(m_FileMutex);
+		WriteEvents(events);
+	}
+
+private:
+	struct ThreadBuffer
+	{
+		std::mutex Mutex;
+		std::vector<ProfileResult> Events;
+		uint32_t ThreadID = 0;
+	};
+
+	//线程退出时把没写完的事件交回给Instrumentor
+	struct ThreadBufferHandle
+	{
+		std::shared_ptr<ThreadBuffer> Buffer;
+
+		~ThreadBufferHandle()
+		{
+			if (Buffer)
+				Instrumentor::Get().FlushBuffer(*Buffer);
+		}
+	};
+
+	Instrumentor() = default;
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		static thread_local ThreadBufferHandle handle;
+		if (!handle.Buffer)
+		{
+			handle.Buffer = std::make_shared<ThreadBuffer>();
+			handle.Buffer->Events.reserve(FlushThreshold);
+
+			std::lock_guard<std::mutex> lock(m_RegistryMutex);
+			handle.Buffer->ThreadID = m_NextThreadID++;
+			m_Buffers.push_back(handle.Buffer);
+		}
+		return *handle.Buffer;
+	}
+
+	void FlushBuffer(ThreadBuffer& buffer)
+	{
+		std::vector<ProfileResult> events;
+		{
+			std::lock_guard<std::mutex> lock(buffer.Mutex);
+			events.swap(buffer.Events);
+		}
+		std::lock_guard<std::mutex> fileLock(m_FileMutex);
+		WriteEvents(events);
+	}
+
+	void EndSessionLocked()
+	{
+		if (!m_Active)
+			return;
+
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		{
+			std::lock_guard<std::mutex> lock(m_RegistryMutex);
+			buffers = m_Buffers;
+		}
+		for (auto& buffer : buffers)
+		{
+			std::vector<ProfileResult> events;
+			{
+				std::lock_guard<std::mutex> lock(buffer->Mutex);
+				events.swap(buffer->Events);
+			}
+			WriteEvents(events);
+		}
+
+		m_OutputStream << "]}";
+		m_OutputStream.close();
+		m_Active = false;
+	}
+
+	//调用者持有m_FileMutex
+	void WriteEvents(const std::vector<ProfileResult>& events)
+	{
+		if (!m_Active)
+			return;
+
+		for (const ProfileResult& result : events)
+		{
+			std::string name = result.Name;
+			std::replace(name.begin(), name.end(), '"', '\'');
+			std::replace(name.begin(), name.end(), '\\', '/');
+
+			if (m_EventCount++ > 0)
+				m_OutputStream << ",";
+
+			m_OutputStream << "{\"cat\":\"function\",\"ph\":\"X\",\"pid\":0"
+				<< ",\"tid\":" << result.ThreadID
+				<< ",\"name\":\"" << name << "\""
+				<< ",\"ts\":" << result.Start
+				<< ",\"dur\":" << (result.End - result.Start) << "}";
+		}
+	}
+
+	std::mutex m_FileMutex;
+	std::ofstream m_OutputStream;
+	std::string m_SessionName;
+	uint64_t m_EventCount = 0;
+	std::atomic<bool> m_Active{ false };
+	std::atomic<std::chrono::steady_clock::rep> m_SessionStart{ 0 }; //steady_clock的tick数
+
+	std::mutex m_RegistryMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> m_Buffers;
+	uint32_t m_NextThreadID = 0;
+};
+
+//作用域计时器：构造时记开始，析构时把这一段交给Instrumentor。
+//开始时没有session就什么都不记，免得白白写进buffer，再被下一次BeginSession清掉
+class InstrumentationTimer
+{
+public:
+	explicit InstrumentationTimer(const char* name)
+		: m_Name(name), m_Stopped(!Instrumentor::Get().IsActive())
+	{
+		if (!m_Stopped)
+			m_Start = Instrumentor::Get().Now();
+	}
+
+	~InstrumentationTimer()
+	{
+		if (!m_Stopped)
+			Stop();
+	}
+
+	void Stop()
+	{
+		Instrumentor& instrumentor = Instrumentor::Get();
+		if (!m_Stopped && instrumentor.IsActive())
+			instrumentor.WriteProfile(m_Name, m_Start, instrumentor.Now());
+		m_Stopped = true;
+	}
+
+private:
+	const char* m_Name;
+	double m_Start = 0.0;
+	bool m_Stopped;
+};
+
+#if PROFILING
+	#if defined(_MSC_VER)
+		#define PROFILE_FUNCSIG __FUNCSIG__
+	#else
+		#define PROFILE_FUNCSIG __PRETTY_FUNCTION__
+	#endif
+	#define PROFILE_CONCAT_IMPL(a, b) a##b
+	#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+	#define PROFILE_SCOPE(name) InstrumentationTimer PROFILE_CONCAT(timer, __LINE__)(name)
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(PROFILE_FUNCSIG)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+#endif
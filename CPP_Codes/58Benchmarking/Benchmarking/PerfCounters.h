@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//硬件性能计数器：cycles / instructions / L1D miss / LLC miss / branch miss。
+//只看微秒分不清是cache miss变多了还是分支预测失败变多了，这些计数器可以。
+//Linux上用perf_event_open，一组计数器一起开关；其他平台或者容器里没权限时IsAvailable()返回false，
+//Start/Stop变成空操作，Timer照常只打印时间。
+class PerfCounters
+{
+public:
+	enum Counter
+	{
+		Cycles, Instructions, L1DMisses, LLCMisses, BranchMisses, CounterCount
+	};
+
+	struct Values
+	{
+		uint64_t Value[CounterCount] = {};
+		bool Valid[CounterCount] = {};
+
+		bool Has(Counter counter) const { return Valid[counter]; }
+
+		double IPC() const
+		{
+			if (!Valid[Cycles] || !Valid[Instructions] || Value[Cycles] == 0)
+				return 0.0;
+			return (double)Value[Instructions] / Value[Cycles];
+		}
+
+		Values& operator+=(const Values& other)
+		{
+			for (int i = 0; i < CounterCount; i++)
+			{
+				Value[i] += other.Value[i];
+				Valid[i] = Valid[i] || other.Valid[i];
+			}
+			return *this;
+		}
+	};
+
+	static const char* Name(Counter counter)
+	{
+		switch (counter)
+		{
+		case Cycles:       return "cycles";
+		case Instructions: return "instructions";
+		case L1DMisses:    return "L1D misses";
+		case LLCMisses:    return "LLC misses";
+		case BranchMisses: return "branch misses";
+		default:           return "unknown";
+		}
+	}
+
+	PerfCounters()
+	{
+#if defined(__linux__)
+		for (int i = 0; i < CounterCount; i++)
+		{
+			m_Fds[i] = -1;
+			Open((Counter)i);
+		}
+#endif
+	}
+
+	~PerfCounters()
+	{
+#if defined(__linux__)
+		for (int i = 0; i < CounterCount; i++)
+		{
+			if (m_Fds[i] != -1)
+				close(m_Fds[i]);
+		}
+#endif
+	}
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	bool IsAvailable() const { return m_Leader != -1; }
+
+	void Start()
+	{
+#if defined(__linux__)
+		if (!IsAvailable())
+			return;
+		ioctl(m_Leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(m_Leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+	}
+
+	Values Stop()
+	{
+		Values values;
+#if defined(__linux__)
+		if (!IsAvailable())
+			return values;
+		ioctl(m_Leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+		//PERF_FORMAT_GROUP | ID | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING 的布局
+		uint64_t buffer[3 + 2 * CounterCount] = {};
+		if (read(m_Leader, buffer, sizeof(buffer)) <= 0)
+			return values;
+
+		uint64_t count = buffer[0], enabled = buffer[1], running = buffer[2];
+		//计数器比PMU硬件寄存器多时内核会分时复用，按实际运行的时间比例放大
+		double scale = (running > 0 && running < enabled) ? (double)enabled / running : 1.0;
+		for (uint64_t i = 0; i < count && i < CounterCount; i++)
+		{
+			uint64_t value = buffer[3 + 2 * i], id = buffer[4 + 2 * i];
+			for (int c = 0; c < CounterCount; c++)
+			{
+				if (m_Fds[c] != -1 && m_Ids[c] == id)
+				{
+					values.Value[c] = (uint64_t)(value * scale);
+					values.Valid[c] = running > 0;
+				}
+			}
+		}
+#endif
+		return values;
+	}
+
+	//IPC和每次迭代的miss数，iterations为0时打印总数
+	static void Print(const Values& values, uint64_t iterations = 0, std::ostream& stream = std::cout)
+	{
+		if (values.Has(Cycles) && values.Has(Instructions))
+			stream << " IPC " << values.IPC();
+
+		double divisor = iterations > 0 ? (double)iterations : 1.0;
+		for (int c = 0; c < CounterCount; c++)
+		{
+			if (values.Valid[c])
+				stream << ", " << Name((Counter)c) << (iterations > 0 ? "/iter " : " ") << values.Value[c] / divisor;
+		}
+	}
+
+private:
+#if defined(__linux__)
+	void Open(Counter counter)
+	{
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.disabled = m_Leader == -1 ? 1 : 0; //只有leader是disabled，组员跟着leader一起开关
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (counter)
+		{
+		case Cycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case Instructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case L1DMisses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case LLCMisses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		case BranchMisses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		default:
+			return;
+		}
+
+		//pid = 0, cpu = -1：只统计当前线程，在哪个核上跑都算
+		int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, m_Leader, 0);
+		if (fd == -1)
+			return; //没权限(perf_event_paranoid)、容器、虚拟机不支持这个事件：跳过这个计数器
+
+		m_Fds[counter] = fd;
+		ioctl(fd, PERF_EVENT_IOC_ID, &m_Ids[counter]);
+		if (m_Leader == -1)
+			m_Leader = fd;
+	}
+
+	int m_Fds[CounterCount];
+	uint64_t m_Ids[CounterCount] = {};
+#endif
+	int m_Leader = -1;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+
+#include "PerfCounters.h"
+#include "TscClock.h"
+
+//Clock可以换成TscClock（TscClock.h），测100ns以内的作用域时开销小得多
+template<typename ClockType = std::chrono::high_resolution_clock>
+class BasicTimer
+{
+public:
+	using Clock = ClockType;
+
+	//print = false时，析构不打印，只用来取时间（给Benchmark.h用）
+	//counters不为空时，同一个作用域里的硬件计数器也一起统计，打印在时间后面
+	explicit BasicTimer(bool print = true, PerfCounters* counters = nullptr)
+		: m_Print(print), m_Counters(counters)
+	{
+		if (m_Counters)
+			m_Counters->Start();
+		m_StartTimepoint = Clock::now();
+	}
+	~BasicTimer()
+	{
+		if (m_Print && !m_Stopped)
+			Stop();
+	}
+
+	void Reset()
+	{
+		m_Stopped = false;
+		if (m_Counters)
+			m_Counters->Start();
+		m_StartTimepoint = Clock::now();
+	}
+
+	//作用域里循环了多少次，打印时换算成每次迭代的miss数
+	void SetIterations(uint64_t iterations) { m_Iterations = iterations; }
+
+	const PerfCounters::Values& CounterValues() const { return m_CounterValues; }
+
+	long long ElapsedNanoseconds() const
+	{
+		auto end = m_Stopped ? m_EndTimepoint : Clock::now();
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_StartTimepoint).count();
+	}
+
+	void Stop()
+	{
+		m_EndTimepoint = Clock::now();
+		if (m_Counters)
+			m_CounterValues = m_Counters->Stop();
+		m_Stopped = true;
+
+		if (!m_Print)
+			return;
+
+		long long nanoseconds = ElapsedNanoseconds();
+		if (nanoseconds < 1000)
+		{
+			std::cout << nanoseconds << "ns";
+		}
+		else
+		{
+			auto start = std::chrono::time_point_cast<std::chrono::microseconds>(m_StartTimepoint).time_since_epoch().count();
+			auto end = std::chrono::time_point_cast<std::chrono::microseconds>(m_EndTimepoint).time_since_epoch().count();
+
+			auto duration = end - start;
+
+			double ms = duration * 0.001;
+
+			std::cout << duration << "us (" << ms << "ms)";
+		}
+		if (m_Counters && m_Counters->IsAvailable())
+			PerfCounters::Print(m_CounterValues, m_Iterations);
+		std::cout << std::endl;
+	}
+
+private:
+	std::chrono::time_point<Clock> m_StartTimepoint, m_EndTimepoint;
+	bool m_Print;
+	bool m_Stopped = false;
+	PerfCounters* m_Counters;
+	PerfCounters::Values m_CounterValues;
+	uint64_t m_Iterations = 0;
+};
+
+using Timer = BasicTimer<>;
+using TscTimer = BasicTimer<TscClock>;
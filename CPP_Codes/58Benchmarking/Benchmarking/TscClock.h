@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TSC_CLOCK_X86 1
+#else
+#define TSC_CLOCK_X86 0
+#endif
+
+//基于rdtsc的时钟：high_resolution_clock::now()一次要几十纳秒，测100ns以内的代码时误差比被测的东西还大。
+//rdtsc只要几纳秒。第一次使用时跟steady_clock对比校准出每纳秒多少tick；
+//CPU不支持invariant TSC（频率会变、不同核之间不同步）时自动退回steady_clock。
+//满足std::chrono的Clock要求，可以直接当Timer的时钟：BasicTimer<TscClock>。
+struct TscClock
+{
+	using rep = int64_t;
+	using period = std::nano;
+	using duration = std::chrono::nanoseconds;
+	using time_point = std::chrono::time_point<TscClock>;
+	static constexpr bool is_steady = true;
+
+	static time_point now() noexcept
+	{
+		const Calibration& calibration = GetCalibration();
+		if (!calibration.Enabled)
+			return time_point(std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()));
+
+		return time_point(duration((rep)((double)(int64_t)(ReadTicks() - calibration.BaseTicks) * calibration.NanosecondsPerTick)));
+	}
+
+	//是否真的在用TSC（否则是steady_clock）
+	static bool IsTscEnabled() { return GetCalibration().Enabled; }
+	static double TicksPerNanosecond() { return GetCalibration().Enabled ? 1.0 / GetCalibration().NanosecondsPerTick : 0.0; }
+
+	//CPUID 0x80000007 EDX bit 8：TSC频率恒定，且在深度睡眠状态下也不停
+	static bool HasInvariantTsc()
+	{
+#if TSC_CLOCK_X86
+		unsigned int regs[4] = {};
+#if defined(_MSC_VER)
+		__cpuid((int*)regs, 0x80000000);
+		if (regs[0] < 0x80000007)
+			return false;
+		__cpuid((int*)regs, 0x80000007);
+#else
+		if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+			return false;
+		__get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+		return (regs[3] & (1u << 8)) != 0;
+#else
+		return false;
+#endif
+	}
+
+	//lfence等前面的指令都执行完再读，避免rdtsc被乱序提前到被测代码之前
+	static uint64_t ReadTicks() noexcept
+	{
+#if TSC_CLOCK_X86
+		_mm_lfence();
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+
+private:
+	struct Calibration
+	{
+		bool Enabled = false;
+		uint64_t BaseTicks = 0;
+		double NanosecondsPerTick = 0.0;
+	};
+
+	static const Calibration& GetCalibration()
+	{
+		static const Calibration calibration = Calibrate();
+		return calibration;
+	}
+
+	//忙等约20ms，用steady_clock的时间除以这段时间的tick数
+	static Calibration Calibrate()
+	{
+		Calibration calibration;
+		if (!HasInvariantTsc())
+			return calibration;
+
+		using namespace std::chrono;
+		auto startTime = steady_clock::now();
+		uint64_t startTicks = ReadTicks();
+
+		auto endTime = startTime;
+		while (endTime - startTime < milliseconds(20))
+			endTime = steady_clock::now();
+		uint64_t endTicks = ReadTicks();
+
+		double nanoseconds = (double)duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+		if (endTicks <= startTicks || nanoseconds <= 0.0)
+			return calibration;
+
+		calibration.Enabled = true;
+		calibration.BaseTicks = startTicks;
+		calibration.NanosecondsPerTick = nanoseconds / (double)(endTicks - startTicks);
+		return calibration;
+	}
+};